@@ -0,0 +1,222 @@
+/*
+  Affine --
+
+  Affine arithmetic restricted to two variables. An affine form
+
+    center + dx*ex + dy*ey + error*e
+
+  with ex, ey, e in [-1, 1] represents a quantity depending on x (through
+  the noise symbol ex) and y (through ey) with all nonlinear and rounding
+  errors gathered in the last term. Contrary to intervals, affine forms
+  keep track of the correlation between subexpressions of x and y.
+
+  The computations of the coefficients are rounded upward and their
+  rounding errors are added to the error term, so that enclosure() is
+  rigorous. As for the interval operators, the FPU must round upward
+  (see upward_rounding).
+
+  See:
+  Self-validated numerical methods and applications. Jorge Stolfi and
+  Luiz Henrique de Figueiredo. IMPA, 1997.
+*/
+
+#ifndef __affine_h__
+#define __affine_h__
+
+#include <cmath>
+#include "interval.h"
+
+namespace affine_detail {
+
+// a+b rounded upward, its rounding error being added to err
+inline double add(double a, double b, double& err)
+{
+  double s = a+b;
+  err += s+((-a)-b);
+  return s;
+}
+
+// a-b rounded upward, its rounding error being added to err
+inline double sub(double a, double b, double& err)
+{
+  double d = a-b;
+  err += d+(b-a);
+  return d;
+}
+
+// a*b rounded upward, its rounding error being added to err
+inline double mul(double a, double b, double& err)
+{
+  double p = a*b;
+  err += p+((-a)*b);
+  return p;
+}
+
+} // namespace affine_detail
+
+struct affine {
+  double center;
+  double dx;    // Coefficient of the noise symbol of x
+  double dy;    // Coefficient of the noise symbol of y
+  double error; // Nonnegative
+
+  // Affine forms of the two variables over the box X*Y
+  static affine x(const interval& X)
+  {
+    interval_detail::operation_rounding rounding;
+    double c = X.mid();
+    return affine{c,radius(X,c),0.0,0.0};
+  }
+  static affine y(const interval& Y)
+  {
+    interval_detail::operation_rounding rounding;
+    double c = Y.mid();
+    return affine{c,0.0,radius(Y,c),0.0};
+  }
+
+  // Sum of the magnitudes of the noise terms, rounded upward
+  double radius(void) const
+  {
+    return std::fabs(dx)+std::fabs(dy)+error;
+  }
+
+  // Interval enclosing all the values of the affine form
+  interval enclosure(void) const
+  {
+    interval_detail::operation_rounding rounding;
+    double r = radius();
+    return interval(-(r-center),center+r);
+  }
+
+private:
+  // Radius of I around c, rounded upward
+  static double radius(const interval& I, double c)
+  {
+    double l = c-I.left();
+    double r = I.right()-c;
+    return (l >= r) ? l : r;
+  }
+};
+
+inline affine operator+(const affine& u, const affine& v)
+{
+  using namespace affine_detail;
+  interval_detail::operation_rounding rounding;
+  double e = u.error+v.error;
+  double c = add(u.center,v.center,e);
+  double dx = add(u.dx,v.dx,e);
+  double dy = add(u.dy,v.dy,e);
+  return affine{c,dx,dy,e};
+}
+
+inline affine operator-(const affine& u, const affine& v)
+{
+  using namespace affine_detail;
+  interval_detail::operation_rounding rounding;
+  double e = u.error+v.error;
+  double c = sub(u.center,v.center,e);
+  double dx = sub(u.dx,v.dx,e);
+  double dy = sub(u.dy,v.dy,e);
+  return affine{c,dx,dy,e};
+}
+
+// The product of the noise parts of u and v is bounded by the product
+// of their radii and goes into the error term
+inline affine operator*(const affine& u, const affine& v)
+{
+  using namespace affine_detail;
+  interval_detail::operation_rounding rounding;
+  double e = std::fabs(u.center)*v.error+std::fabs(v.center)*u.error
+    +u.radius()*v.radius();
+  double c = mul(u.center,v.center,e);
+  double dx = add(mul(u.center,v.dx,e),mul(v.center,u.dx,e),e);
+  double dy = add(mul(u.center,v.dy,e),mul(v.center,u.dy,e),e);
+  return affine{c,dx,dy,e};
+}
+
+inline affine operator+(double c, const affine& u)
+{
+  interval_detail::operation_rounding rounding;
+  double e = u.error;
+  return affine{affine_detail::add(c,u.center,e),u.dx,u.dy,e};
+}
+
+inline affine operator+(const affine& u, double c)
+{
+  return c+u;
+}
+
+inline affine operator-(const affine& u, double c)
+{
+  interval_detail::operation_rounding rounding;
+  double e = u.error;
+  return affine{affine_detail::sub(u.center,c,e),u.dx,u.dy,e};
+}
+
+inline affine operator-(double c, const affine& u)
+{
+  interval_detail::operation_rounding rounding;
+  double e = u.error;
+  return affine{affine_detail::sub(c,u.center,e),-u.dx,-u.dy,e};
+}
+
+inline affine operator*(double c, const affine& u)
+{
+  using namespace affine_detail;
+  interval_detail::operation_rounding rounding;
+  double e = std::fabs(c)*u.error;
+  double center = mul(c,u.center,e);
+  double dx = mul(c,u.dx,e);
+  double dy = mul(c,u.dy,e);
+  return affine{center,dx,dy,e};
+}
+
+inline affine operator*(const affine& u, double c)
+{
+  return c*u;
+}
+
+// Square of u: the square of its noise part lies in [0, r^2] for r the
+// radius of u, which is centered by adding r^2/2 to the center
+inline affine sqr(const affine& u)
+{
+  using namespace affine_detail;
+  interval_detail::operation_rounding rounding;
+  double r = u.radius();
+  double h = 0.5*(r*r);
+  double e = h+2.0*std::fabs(u.center)*u.error;
+  double c = add(mul(u.center,u.center,e),h,e);
+  double dx = mul(2.0*u.center,u.dx,e);
+  double dy = mul(2.0*u.center,u.dy,e);
+  return affine{c,dx,dy,e};
+}
+
+namespace affine_detail {
+
+template<unsigned int N>
+struct power {
+  static affine of(const affine& u)
+  {
+    return (N % 2) ? power<N-1>::of(u)*u : sqr(power<N/2>::of(u));
+  }
+};
+
+template<>
+struct power<1> {
+  static affine of(const affine& u) { return u; }
+};
+
+template<>
+struct power<0> {
+  static affine of(const affine& u) { return affine{1.0,0.0,0.0,0.0}; }
+};
+
+} // namespace affine_detail
+
+template<unsigned int N>
+inline affine pow(const affine& u)
+{
+  return affine_detail::power<N>::of(u);
+}
+
+#endif // __affine_h__
@@ -0,0 +1,183 @@
+/*
+  Arena --
+
+  Growable array of T stored in chunks of about 64 KiB, allocated when
+  the array grows past its last chunk and released when it shrinks
+  below them. Unlike std::vector, growing never moves the elements
+  (a vector doubling its capacity copies them and briefly holds both
+  copies), and truncating the array releases whole chunks at once.
+
+  The chunks are owned by the array: nothing outlives it, whatever the
+  thread that destroys it. T must be trivially copyable.
+*/
+
+#ifndef __arena_h__
+#define __arena_h__
+
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+template<typename T>
+class arena_array {
+  static_assert(std::is_trivially_copyable<T>::value,
+		"Arena elements are moved as raw bytes");
+
+  // Largest power of 2 not greater than n
+  static constexpr std::size_t floor2(std::size_t n)
+  {
+    return (n < 2) ? 1 : 2*floor2(n/2);
+  }
+
+public:
+  // Number of elements of a chunk: a power of 2, so that an index is
+  // split into a chunk and an offset by a shift and a mask
+  static const std::size_t per_chunk = floor2((std::size_t(1) << 16)/sizeof(T));
+
+  // Random-access iterator over the array (CT: T or const T)
+  template<typename CT>
+  class basic_iterator {
+  public:
+    typedef std::random_access_iterator_tag iterator_category;
+    typedef T value_type;
+    typedef std::ptrdiff_t difference_type;
+    typedef CT* pointer;
+    typedef CT& reference;
+
+    basic_iterator() : chunks(nullptr), i(0) {}
+    basic_iterator(const std::unique_ptr<T[]>* chunks, std::size_t i)
+      : chunks(chunks), i(i) {}
+    // Conversion of an iterator to a const_iterator
+    template<typename U>
+    basic_iterator(const basic_iterator<U>& it,
+		   typename std::enable_if<std::is_same<U,T>::value>::type* = nullptr)
+      : chunks(it.chunks), i(it.i) {}
+
+    reference operator*() const { return chunks[i/per_chunk][i%per_chunk]; }
+    pointer operator->() const { return &**this; }
+    reference operator[](difference_type n) const { return *(*this+n); }
+
+    basic_iterator& operator++() { ++i; return *this; }
+    basic_iterator& operator--() { --i; return *this; }
+    basic_iterator operator++(int) { basic_iterator it = *this; ++i; return it; }
+    basic_iterator operator--(int) { basic_iterator it = *this; --i; return it; }
+    basic_iterator& operator+=(difference_type n) { i += n; return *this; }
+    basic_iterator& operator-=(difference_type n) { i -= n; return *this; }
+    basic_iterator operator+(difference_type n) const { return basic_iterator(chunks,i+n); }
+    basic_iterator operator-(difference_type n) const { return basic_iterator(chunks,i-n); }
+    friend basic_iterator operator+(difference_type n, const basic_iterator& it)
+    {
+      return it+n;
+    }
+    difference_type operator-(const basic_iterator& it) const
+    {
+      return difference_type(i)-difference_type(it.i);
+    }
+
+    bool operator==(const basic_iterator& it) const { return i == it.i; }
+    bool operator!=(const basic_iterator& it) const { return i != it.i; }
+    bool operator<(const basic_iterator& it) const { return i < it.i; }
+    bool operator>(const basic_iterator& it) const { return i > it.i; }
+    bool operator<=(const basic_iterator& it) const { return i <= it.i; }
+    bool operator>=(const basic_iterator& it) const { return i >= it.i; }
+
+  private:
+    template<typename> friend class basic_iterator;
+
+    const std::unique_ptr<T[]>* chunks;
+    std::size_t i;
+  };
+
+  typedef basic_iterator<T> iterator;
+  typedef basic_iterator<const T> const_iterator;
+
+  arena_array() : n(0), tail(nullptr), tail_end(nullptr) {}
+  arena_array(arena_array&& a) noexcept : arena_array() { swap(a); }
+  arena_array& operator=(arena_array&& a) noexcept { swap(a); return *this; }
+
+  void swap(arena_array& a) noexcept
+  {
+    chunks.swap(a.chunks);
+    std::swap(n,a.n);
+    std::swap(tail,a.tail);
+    std::swap(tail_end,a.tail_end);
+  }
+
+  std::size_t size(void) const { return n; }
+
+  void push_back(const T& v)
+  {
+    if (tail == tail_end) {
+      chunks.emplace_back(new T[per_chunk]);
+      tail = chunks.back().get();
+      tail_end = tail+per_chunk;
+    }
+    *tail++ = v;
+    ++n;
+  }
+
+  // Removes the elements satisfying pred, keeping the order of the
+  // others, and releases the chunks left empty. The elements are read
+  // and written chunk by chunk.
+  template<typename Predicate>
+  void remove_if(Predicate pred)
+  {
+    if (n == 0) {
+      return ;
+    }
+    std::size_t kept = 0;
+    T* out = chunks[0].get();
+    T* out_end = out+per_chunk;
+    for (std::size_t c = 0; c*per_chunk < n; ++c) {
+      const T* in = chunks[c].get();
+      const T* in_end = in+std::min(per_chunk,n-c*per_chunk);
+      for (; in != in_end; ++in) {
+	if (pred(*in)) {
+	  continue;
+	}
+	if (out == out_end) {
+	  out = chunks[kept/per_chunk].get();
+	  out_end = out+per_chunk;
+	}
+	*out++ = *in;
+	++kept;
+      }
+    }
+    truncate(kept);
+  }
+
+  // Keeps the first m elements only, releasing the chunks left empty
+  void truncate(std::size_t m)
+  {
+    if (m >= n) {
+      return ;
+    }
+    n = m;
+    chunks.resize((n+per_chunk-1)/per_chunk);
+    if (n % per_chunk == 0) {
+      // The last chunk kept, if any, is full
+      tail = tail_end = nullptr;
+    } else {
+      tail = chunks.back().get()+n%per_chunk;
+      tail_end = chunks.back().get()+per_chunk;
+    }
+  }
+
+  void clear(void) { truncate(0); }
+
+  iterator begin(void) { return iterator(chunks.data(),0); }
+  iterator end(void) { return iterator(chunks.data(),n); }
+  const_iterator begin(void) const { return const_iterator(chunks.data(),0); }
+  const_iterator end(void) const { return const_iterator(chunks.data(),n); }
+
+private:
+  std::vector<std::unique_ptr<T[]> > chunks;
+  std::size_t n; // Number of elements
+  T* tail; // Next free slot of the last chunk
+  T* tail_end; // End of the last chunk
+};
+
+#endif // __arena_h__
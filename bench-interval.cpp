@@ -0,0 +1,209 @@
+/*
+  Benchmark of the interval arithmetic --
+
+  Evaluates each function of the database on a grid of small boxes
+  covering its initial domain and reports the average time of one
+  evaluation, box by box, box by box through expression templates and
+  one row of the grid at a time with the batch version of the function.
+
+  The natural extension is then compared with the affine arithmetic
+  backend: for each, the number of evaluations per second and the
+  percentage of the boxes of the grid it could discard, i.e. the boxes
+  over which its lower bound exceeds the best upper bound found by the
+  natural extension on the grid.
+
+  The same source is compiled twice by the Makefile:
+  - bench-interval: the FPU rounds upward during the whole run;
+  - bench-interval-switch: each operator switches the rounding direction
+    (INTERVAL_SWITCH_ROUNDING).
+  Both must report the same checksums, which make bench checks. The
+  switching operators keep their operations between their calls to
+  fesetround (see operation_rounding in interval.h).
+
+  With --check, the benchmark is replaced by a check of the products
+  whose bounds include 0*inf, which must count as 0 (make check).
+
+  Usage: bench-interval [grid size] [repetitions]
+         bench-interval --check
+*/
+
+#include <iostream>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <chrono>
+#include <vector>
+#include <algorithm>
+#include "interval.h"
+#include "functions.h"
+
+using namespace std;
+
+// Prevents the compiler from hoisting the evaluations out of the
+// repetition loop once they are inlined
+inline void clobber_memory(void)
+{
+  asm volatile("" : : : "memory");
+}
+
+// Evaluation of f over all the boxes xs[i]*ys[j] repeated a number of
+// times. Returns the checksum of the results and sets the time elapsed.
+double time_evaluations(itvfun f,
+			const vector<interval>& xs, const vector<interval>& ys,
+			int repetitions, double& seconds, vector<interval>& results)
+{
+  results.resize(xs.size()*ys.size());
+
+  auto start = chrono::steady_clock::now();
+  {
+    upward_rounding rounding;
+    for (int k = 0; k < repetitions; ++k) {
+      clobber_memory();
+      for (size_t i = 0; i < xs.size(); ++i) {
+	for (size_t j = 0; j < ys.size(); ++j) {
+	  results[i*ys.size()+j] = f(xs[i],ys[j]);
+	}
+      }
+    }
+  }
+  chrono::duration<double> elapsed = chrono::steady_clock::now()-start;
+  seconds = elapsed.count();
+
+  double checksum = 0;
+  for (auto fxy : results) {
+    checksum += fxy.right()-fxy.left();
+  }
+  return checksum;
+}
+
+// Percentage of the enclosures whose lower bound exceeds ub
+double prunable(const vector<interval>& results, double ub)
+{
+  size_t n = count_if(results.begin(),results.end(),
+		      [ub](const interval& fxy) { return fxy.left() > ub; });
+  return 100.0*n/results.size();
+}
+
+// Does the product a*b, computed with both operand orders, give the
+// interval [l, r]? Reports the failures
+bool check_product(const interval& a, const interval& b, double l, double r)
+{
+  bool ok = true;
+  upward_rounding rounding;
+  for (interval p : {a*b, b*a}) {
+    if (!(p.left() == l && p.right() == r)) {
+      cout << a << "*" << b << ": " << p << " instead of ["
+	   << l << ", " << r << "]" << endl;
+      ok = false;
+    }
+  }
+  return ok;
+}
+
+// Products involving 0*inf, and a few ordinary ones
+int check_products(void)
+{
+  const double inf = numeric_limits<double>::infinity();
+  bool ok = check_product(interval(-2,0),interval(-3,inf),-inf,6);
+  ok &= check_product(interval(0,0),interval(-inf,inf),0,0);
+  ok &= check_product(interval(0,0),interval(-inf,1),0,0);
+  ok &= check_product(interval(0,1),interval(1,inf),0,inf);
+  ok &= check_product(interval(-1,0),interval(-inf,-2),0,inf);
+  ok &= check_product(interval(-2,3),interval(-1,4),-8,12);
+  ok &= check_product(interval(1,2),interval(3,4),3,8);
+  {
+    upward_rounding rounding;
+    interval p = 0.0*interval(-inf,inf);
+    if (!(p.left() == 0 && p.right() == 0)) {
+      cout << "0*[-inf, inf]: " << p << " instead of [0, 0]" << endl;
+      ok = false;
+    }
+  }
+  cout << (ok ? "All the products are right" : "Wrong products") << endl;
+  return ok ? 0 : 1;
+}
+
+int main(int argc, char *argv[])
+{
+  if (argc > 1 && strcmp(argv[1],"--check") == 0) {
+    return check_products();
+  }
+  // Number of boxes along each dimension
+  int grid = (argc > 1) ? atoi(argv[1]) : 200;
+  // Number of times the whole grid is evaluated
+  int repetitions = (argc > 2) ? atoi(argv[2]) : 20;
+  cout.precision(16);
+
+#ifdef INTERVAL_SWITCH_ROUNDING
+  cout << "Rounding: switched at each operation\n";
+#else
+  cout << "Rounding: upward for the whole run\n";
+#endif
+
+  for (auto fname : functions) {
+    const opt_fun_t& fun = fname.second;
+    double wx = fun.x.width()/grid;
+    double wy = fun.y.width()/grid;
+
+    // The boxes are computed beforehand with the default rounding
+    // so that both versions evaluate the same ones
+    vector<interval> xs, ys;
+    for (int i = 0; i < grid; ++i) {
+      xs.push_back(interval(fun.x.left()+i*wx,fun.x.left()+(i+1)*wx));
+      ys.push_back(interval(fun.y.left()+i*wy,fun.y.left()+(i+1)*wy));
+    }
+    double evaluations = double(repetitions)*grid*grid;
+    double seconds;
+    vector<interval> natural, results;
+
+    double checksum = time_evaluations(fun.f,xs,ys,repetitions,seconds,
+				       natural);
+    double natural_seconds = seconds;
+    cout << fname.first << ": " << 1e9*seconds/evaluations
+	 << " ns/evaluation (checksum " << checksum << ")" << endl;
+
+    checksum = time_evaluations(fun.fe,xs,ys,repetitions,seconds,results);
+    cout << fname.first << ": " << 1e9*seconds/evaluations
+	 << " ns/evaluation with expression templates (checksum "
+	 << checksum << ")" << endl;
+
+    // Same evaluations by rows of the grid with the batch version
+    vector<double> xl(grid), xr(grid), yl(grid), yr(grid);
+    vector<double> fl(grid*grid), fr(grid*grid);
+    for (int j = 0; j < grid; ++j) {
+      yl[j] = ys[j].left();
+      yr[j] = ys[j].right();
+    }
+    auto start = chrono::steady_clock::now();
+    {
+      upward_rounding rounding;
+      for (int k = 0; k < repetitions; ++k) {
+	clobber_memory();
+	for (int i = 0; i < grid; ++i) {
+	  fill(xl.begin(),xl.end(),xs[i].left());
+	  fill(xr.begin(),xr.end(),xs[i].right());
+	  fun.fb(grid,&xl[0],&xr[0],&yl[0],&yr[0],&fl[i*grid],&fr[i*grid]);
+	}
+      }
+    }
+    chrono::duration<double> elapsed = chrono::steady_clock::now()-start;
+
+    checksum = 0;
+    for (int i = 0; i < grid*grid; ++i) {
+      checksum += fr[i]-fl[i];
+    }
+    cout << fname.first << ": " << 1e9*elapsed.count()/evaluations
+	 << " ns/evaluation in batch (checksum " << checksum << ")" << endl;
+
+    // Tightness against speed of the bounding backends
+    double ub = min_element(natural.begin(),natural.end(),
+			    [](const interval& a, const interval& b) {
+			      return a.right() < b.right();
+			    })->right();
+    cout << fname.first << ": natural " << evaluations/natural_seconds
+	 << " evaluations/s, " << prunable(natural,ub) << "% prunable" << endl;
+    time_evaluations(fun.fa,xs,ys,repetitions,seconds,results);
+    cout << fname.first << ": affine " << evaluations/seconds
+	 << " evaluations/s, " << prunable(results,ub) << "% prunable" << endl;
+  }
+}
@@ -0,0 +1,588 @@
+/*
+  Benchmark of the whole search --
+
+  Runs optimization-seq, optimization-omp and optimization-mpi on every
+  function of the database over a range of precisions and records, for
+  each run, the wall time, the peak memory (largest resident set size
+  among the processes of the run, MPI processes included), the number
+  of minimizers, the upper bound and, when the program reports them,
+  the numbers of boxes evaluated and pruned and the boxes evaluated per
+  second. The results are written as JSON, one run per line, so that
+  the files written for two builds can be compared with --compare.
+
+  Each run is repeated and the median wall time is reported along with
+  the fastest one. The memory is that of the first repetition.
+
+  With --scaling, the benchmark measures instead how optimization-omp
+  scales with the number of threads and optimization-mpi with the
+  number of processes (one thread each), for each number of workers W
+  given by --workers, against optimization-seq --no-descent, which
+  explores the same boxes with one thread:
+   - strong scaling: all the runs use the same precision; the speedup
+     is the time of optimization-seq over that of the run and the
+     efficiency is the speedup over W;
+   - weak scaling: the precision is divided by sqrt(W), since the number
+     of boxes of a 2D search grows at most as the square of the inverse
+     of the precision. The growth is actually smaller and irregular (the
+     depth of the search only changes when the precision crosses a
+     power of 2), hence the efficiency is that of the boxes evaluated
+     per second and per worker relative to optimization-seq at the
+     original precision.
+  The "work" of a run is its number of boxes evaluated over that of
+  optimization-seq.
+
+  With --check, the benchmark checks instead that optimization-omp, run
+  with each number of threads given by --workers, finds the same upper
+  bound and the same number of minimizers as optimization-seq
+  --no-descent. Both split the boxes the same way and keep all the
+  boxes whose lower bound does not exceed the final upper bound, which
+  is the smallest upper bound over the boxes of the tree whatever the
+  order of exploration: the results must be identical. The exit status
+  is 1 on any mismatch or failed run.
+
+  Usage: bench-search [--precisions=P1,P2,...] [--engines=seq,omp,mpi]
+                      [--functions=F1,F2,...] [--repeat=R]
+                      [--timeout=SECONDS] [--mpi-procs=N]
+                      [--mpirun=COMMAND] [--out=FILE]
+         bench-search --scaling=strong|weak [--workers=W1,W2,...] ...
+         bench-search --check [--workers=W1,W2,...] ...
+         bench-search --compare BEFORE.json AFTER.json
+
+  Without --scaling, the OpenMP programs use the number of threads
+  given by OMP_NUM_THREADS. COMMAND is the launcher of the MPI program
+  (default: "mpirun"), to which "-n N optimization-mpi" is appended.
+*/
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <map>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include "interval.h"
+#include "functions.h"
+
+#if _OPENMP
+#   include <omp.h>
+#else
+inline int omp_get_max_threads(void) { return 1; }
+#endif
+
+using namespace std;
+
+// Outcome of one execution of a program
+struct execution {
+  string status; // "ok", "timeout" or "failed"
+  double seconds;
+  long max_rss_kb;
+  string output;
+};
+
+// Process group of the program run, killed on timeout
+pid_t program_group = 0;
+volatile sig_atomic_t timed_out = 0;
+
+void kill_program(int)
+{
+  timed_out = 1;
+  kill(-program_group,SIGKILL);
+}
+
+// Execution of the program argv with input as its standard input and
+// the variables env ("NAME=VALUE") added to its environment. An
+// intermediate process runs the program in its own process group and
+// waits for it, so that its resource usage for its children is the
+// largest one of all the processes of the run, e.g., the MPI processes
+// launched by mpirun.
+execution execute(const vector<string>& argv, const vector<string>& env,
+		  const string& input, double timeout)
+{
+  int in[2], out[2], report[2];
+  if (pipe(in) != 0 || pipe(out) != 0 || pipe(report) != 0) {
+    return execution{"failed",0,0,""};
+  }
+
+  auto start = chrono::steady_clock::now();
+  pid_t runner = fork();
+  if (runner == 0) {
+    close(in[1]);
+    close(out[0]);
+    close(report[0]);
+    pid_t program = fork();
+    if (program == 0) {
+      setpgid(0,0);
+      dup2(in[0],0);
+      dup2(out[1],1);
+      int null = open("/dev/null",O_WRONLY);
+      dup2(null,2);
+      for (const string& v : env) {
+	putenv(const_cast<char*>(v.c_str()));
+      }
+      vector<char*> args;
+      for (const string& a : argv) {
+	args.push_back(const_cast<char*>(a.c_str()));
+      }
+      args.push_back(nullptr);
+      execvp(args[0],args.data());
+      _exit(127);
+    }
+    close(in[0]);
+    close(out[1]);
+    setpgid(program,program);
+    program_group = program;
+    signal(SIGALRM,kill_program);
+    alarm(unsigned(ceil(timeout)));
+    int status;
+    while (waitpid(program,&status,0) < 0 && errno == EINTR) {
+    }
+    alarm(0);
+    struct rusage usage;
+    getrusage(RUSAGE_CHILDREN,&usage);
+    long result[2] = {
+      timed_out ? 1 : (WIFEXITED(status) && WEXITSTATUS(status) == 0) ? 0 : 2,
+      usage.ru_maxrss
+    };
+    ssize_t written = write(report[1],result,sizeof(result));
+    _exit(written == sizeof(result) ? 0 : 1);
+  }
+  close(in[0]);
+  close(out[1]);
+  close(report[1]);
+
+  ssize_t written = write(in[1],input.data(),input.size());
+  close(in[1]);
+  execution e{"failed",0,0,""};
+  char buffer[4096];
+  ssize_t n;
+  while ((n = read(out[0],buffer,sizeof(buffer))) > 0) {
+    e.output.append(buffer,n);
+  }
+  close(out[0]);
+  long result[2];
+  bool reported = read(report[0],result,sizeof(result)) == sizeof(result);
+  close(report[0]);
+  waitpid(runner,nullptr,0);
+  e.seconds = chrono::duration<double>(chrono::steady_clock::now()-start).count();
+
+  if (reported && written == ssize_t(input.size())) {
+    e.status = (result[0] == 0) ? "ok" : (result[0] == 1) ? "timeout" : "failed";
+    e.max_rss_kb = result[1];
+  }
+  return e;
+}
+
+// Value written after label in the output of a program, as a JSON
+// number, or null if there is none
+string reported(const string& output, const string& label)
+{
+  size_t p = output.find(label);
+  if (p == string::npos) {
+    return "null";
+  }
+  istringstream is(output.substr(p+label.size()));
+  double v;
+  if (!(is >> v) || !isfinite(v)) {
+    return "null";
+  }
+  ostringstream os;
+  os.precision(16);
+  os << v;
+  return os.str();
+}
+
+// Runs the program repeat times, stopping at the first failure. Returns
+// the first execution, with the median wall time and the status of the
+// failure, if any. The fastest time is saved in fastest.
+execution measure(const vector<string>& argv, const vector<string>& env,
+		  const string& input, int repeat, double timeout,
+		  double& fastest)
+{
+  vector<double> seconds;
+  execution e;
+  for (int k = 0; k < repeat; ++k) {
+    execution r = execute(argv,env,input,timeout);
+    if (k == 0) {
+      e = r;
+    }
+    if (r.status != "ok") {
+      e.status = r.status;
+      break;
+    }
+    seconds.push_back(r.seconds);
+  }
+  if (e.status == "ok") {
+    sort(seconds.begin(),seconds.end());
+    e.seconds = seconds[seconds.size()/2];
+    fastest = seconds[0];
+  }
+  return e;
+}
+
+string json_number(double v)
+{
+  if (!isfinite(v)) {
+    return "null";
+  }
+  ostringstream s;
+  s.precision(6);
+  s << v;
+  return s.str();
+}
+
+vector<string> split(const string& s, char separator)
+{
+  vector<string> fields;
+  istringstream is(s);
+  string field;
+  while (getline(is,field,separator)) {
+    if (!field.empty()) {
+      fields.push_back(field);
+    }
+  }
+  return fields;
+}
+
+// Value of the field key of the JSON line written for a run (see main)
+string field(const string& line, const string& key)
+{
+  string quoted = "\"" + key + "\": ";
+  size_t p = line.find(quoted);
+  if (p == string::npos) {
+    return "";
+  }
+  p += quoted.size();
+  size_t q = line.find_first_of(",}",p);
+  string v = line.substr(p,q-p);
+  v.erase(remove(v.begin(),v.end(),'"'),v.end());
+  return v;
+}
+
+// Comparison of the median times of the runs found in both files
+int compare(const string& before, const string& after)
+{
+  ifstream is(before), js(after);
+  if (!is || !js) {
+    cerr << "Cannot read " << (is ? after : before) << endl;
+    return 1;
+  }
+  // A run is identified by its engine, function and precision, and by
+  // its number of workers in a scaling benchmark
+  auto key = [](const string& line) {
+    string k = field(line,"engine") + " " + field(line,"function") + " "
+      + field(line,"precision");
+    string workers = field(line,"workers");
+    return workers.empty() ? k : k + " x" + workers;
+  };
+  map<string,string> runs;
+  string line;
+  while (getline(is,line)) {
+    if (line.find("\"engine\"") != string::npos) {
+      runs[key(line)] = line;
+    }
+  }
+
+  cout.precision(3);
+  cout << fixed;
+  double log_ratios = 0;
+  int compared = 0;
+  while (getline(js,line)) {
+    if (line.find("\"engine\"") == string::npos) {
+      continue;
+    }
+    auto old = runs.find(key(line));
+    if (old == runs.end()) {
+      continue;
+    }
+    string t0 = field(old->second,"seconds");
+    string t1 = field(line,"seconds");
+    cout << key(line) << ": " << t0 << " s -> " << t1 << " s";
+    if (field(old->second,"status") == "ok" && field(line,"status") == "ok") {
+      double ratio = stod(t1)/stod(t0);
+      log_ratios += log(ratio);
+      ++compared;
+      cout << " (x" << ratio << ")";
+      if (field(old->second,"upper_bound") != field(line,"upper_bound")) {
+	cout << " upper bound " << field(old->second,"upper_bound")
+	     << " -> " << field(line,"upper_bound");
+      }
+    } else {
+      cout << " (" << field(old->second,"status") << " -> "
+	   << field(line,"status") << ")";
+    }
+    cout << endl;
+  }
+  if (compared > 0) {
+    cout << "Geometric mean of the time ratios: x"
+	 << exp(log_ratios/compared) << " over " << compared << " runs" << endl;
+  }
+  return 0;
+}
+
+// Scaling of optimization-omp and optimization-mpi (see the top of the
+// file), written as JSON to os, one run per line
+void scaling(ostream& os, bool weak, const vector<string>& engines,
+	     const vector<string>& names, const vector<string>& precisions,
+	     const vector<int>& workers, int repeat, double timeout,
+	     const string& mpirun)
+{
+  os << "{\"scaling\": \"" << (weak ? "weak" : "strong") << "\""
+     << ", \"repeat\": " << repeat << ", \"runs\": [" << endl;
+  bool first = true;
+  for (const string& name : names) {
+    for (const string& precision : precisions) {
+      string input = name + " " + precision + "\n";
+      double fastest;
+      execution seq = measure({"./optimization-seq","--no-descent"},{},input,
+			      repeat,timeout,fastest);
+      string seq_evaluated = reported(seq.output,"Number of boxes evaluated:");
+      bool reference = seq.status == "ok" && seq_evaluated != "null";
+      cerr << "seq " << name << " " << precision << ": " << seq.status
+	   << " " << seq.seconds << " s" << endl;
+
+      for (const string& engine : engines) {
+	if (engine == "seq") {
+	  continue;
+	}
+	for (int w : workers) {
+	  vector<string> command;
+	  vector<string> env;
+	  if (engine == "mpi") {
+	    command = split(mpirun,' ');
+	    command.push_back("-n");
+	    command.push_back(to_string(w));
+	    env.push_back("OMP_NUM_THREADS=1");
+	  } else {
+	    env.push_back("OMP_NUM_THREADS=" + to_string(w));
+	  }
+	  command.push_back("./optimization-" + engine);
+	  string p = json_number(weak ? stod(precision)/sqrt(w) : stod(precision));
+	  execution e = measure(command,env,name + " " + p + "\n",repeat,timeout,
+				fastest);
+
+	  string evaluated = reported(e.output,"Number of boxes evaluated:");
+	  string seconds = "null", work = "null", speedup = "null",
+	    efficiency = "null";
+	  if (e.status == "ok") {
+	    seconds = json_number(e.seconds);
+	    if (reference && evaluated != "null") {
+	      double boxes = stod(evaluated)/stod(seq_evaluated);
+	      double s = seq.seconds/e.seconds;
+	      work = json_number(boxes);
+	      speedup = json_number(s);
+	      efficiency = json_number(weak ? boxes*s/w : s/w);
+	    }
+	  }
+	  os << (first ? "" : ",\n")
+	     << "{\"engine\": \"" << engine << "\""
+	     << ", \"function\": \"" << name << "\""
+	     << ", \"workers\": " << w
+	     << ", \"precision\": " << p
+	     << ", \"status\": \"" << e.status << "\""
+	     << ", \"seconds\": " << seconds
+	     << ", \"boxes_evaluated\": " << evaluated
+	     << ", \"seq_seconds\": "
+	     << (seq.status == "ok" ? json_number(seq.seconds) : "null")
+	     << ", \"seq_boxes_evaluated\": " << seq_evaluated
+	     << ", \"work\": " << work
+	     << ", \"speedup\": " << speedup
+	     << ", \"efficiency\": " << efficiency << "}";
+	  first = false;
+	  cerr << engine << " x" << w << " " << name << " " << p << ": "
+	       << e.status << " " << seconds << " s, efficiency "
+	       << efficiency << endl;
+	}
+      }
+    }
+  }
+  os << "\n]}" << endl;
+}
+
+// Cross-check of optimization-omp against optimization-seq (see the
+// top of the file). Returns the exit status of the program
+int check(const vector<string>& names, const vector<string>& precisions,
+	  const vector<int>& workers, double timeout)
+{
+  int mismatches = 0;
+  for (const string& name : names) {
+    for (const string& precision : precisions) {
+      string input = name + " " + precision + "\n";
+      execution seq = execute({"./optimization-seq","--no-descent"},{},input,
+			      timeout);
+      string ub = reported(seq.output,"Upper bound for minimum:");
+      string count = reported(seq.output,"Number of minimizers:");
+      if (seq.status != "ok") {
+	cout << name << " " << precision << ": seq " << seq.status << endl;
+	++mismatches;
+	continue;
+      }
+      for (int w : workers) {
+	execution e = execute({"./optimization-omp"},
+			      {"OMP_NUM_THREADS=" + to_string(w)},input,timeout);
+	string omp_ub = reported(e.output,"Upper bound for minimum:");
+	string omp_count = reported(e.output,"Number of minimizers:");
+	cout << name << " " << precision << " x" << w << ": ";
+	if (e.status != "ok") {
+	  cout << "omp " << e.status;
+	  ++mismatches;
+	} else if (omp_ub != ub || omp_count != count) {
+	  cout << "MISMATCH upper bound " << omp_ub << " (seq " << ub << "), "
+	       << omp_count << " minimizers (seq " << count << ")";
+	  ++mismatches;
+	} else {
+	  cout << "ok (" << ub << ", " << count << " minimizers)";
+	}
+	cout << endl;
+      }
+    }
+  }
+  cout << (mismatches ? "Runs disagreeing or failed: " + to_string(mismatches)
+	   : "All the runs agree") << endl;
+  return mismatches ? 1 : 0;
+}
+
+int main(int argc, char *argv[])
+{
+  vector<string> precisions = {"0.01", "0.001", "0.0001"};
+  vector<string> engines = {"seq", "omp", "mpi"};
+  vector<string> names;
+  for (auto fname : functions) {
+    names.push_back(fname.first);
+  }
+  int repeat = 3;
+  double timeout = 300;
+  int mpi_procs = 2;
+  string mpirun = "mpirun";
+  string out_file;
+  string scaling_mode;
+  vector<int> workers = {1, 2, 4};
+  bool checking = false;
+  for (int i = 1; i < argc; ++i) {
+    string option(argv[i]);
+    if (option == "--compare" && i+2 < argc) {
+      return compare(argv[i+1],argv[i+2]);
+    } else if (option.compare(0,13,"--precisions=") == 0) {
+      precisions = split(option.substr(13),',');
+    } else if (option.compare(0,10,"--engines=") == 0) {
+      engines = split(option.substr(10),',');
+    } else if (option.compare(0,12,"--functions=") == 0) {
+      names = split(option.substr(12),',');
+    } else if (option.compare(0,9,"--repeat=") == 0) {
+      repeat = max(1,atoi(option.c_str()+9));
+    } else if (option.compare(0,10,"--timeout=") == 0) {
+      timeout = atof(option.c_str()+10);
+    } else if (option.compare(0,12,"--mpi-procs=") == 0) {
+      mpi_procs = atoi(option.c_str()+12);
+    } else if (option.compare(0,9,"--mpirun=") == 0) {
+      mpirun = option.substr(9);
+    } else if (option.compare(0,6,"--out=") == 0) {
+      out_file = option.substr(6);
+    } else if (option == "--scaling=strong" || option == "--scaling=weak") {
+      scaling_mode = option.substr(10);
+    } else if (option == "--check") {
+      checking = true;
+    } else if (option.compare(0,10,"--workers=") == 0) {
+      workers.clear();
+      for (const string& w : split(option.substr(10),',')) {
+	workers.push_back(max(1,atoi(w.c_str())));
+      }
+    } else {
+      cerr << "Unknown option: " << argv[i] << endl;
+      return 1;
+    }
+  }
+  for (const string& name : names) {
+    if (functions.find(name) == functions.end()) {
+      cerr << "Unknown function: " << name << endl;
+      return 1;
+    }
+  }
+  // The precisions are written to the JSON lines as numbers
+  for (const string& precision : precisions) {
+    char* end;
+    double v = strtod(precision.c_str(),&end);
+    if (*end != '\0' || !(v > 0) || !isfinite(v)) {
+      cerr << "Bad precision: " << precision << endl;
+      return 1;
+    }
+  }
+
+  if (checking) {
+    return check(names,precisions,workers,timeout);
+  }
+
+  ofstream file;
+  if (!out_file.empty()) {
+    file.open(out_file);
+  }
+  ostream& os = out_file.empty() ? cout : file;
+
+  if (!scaling_mode.empty()) {
+    scaling(os,scaling_mode == "weak",engines,names,precisions,workers,
+	    repeat,timeout,mpirun);
+    return 0;
+  }
+
+  os << "{\"threads\": " << omp_get_max_threads()
+     << ", \"mpi_procs\": " << mpi_procs
+     << ", \"repeat\": " << repeat << ", \"runs\": [" << endl;
+  bool first = true;
+  for (const string& engine : engines) {
+    vector<string> command;
+    if (engine == "mpi") {
+      command = split(mpirun,' ');
+      command.push_back("-n");
+      command.push_back(to_string(mpi_procs));
+    }
+    command.push_back("./optimization-" + engine);
+
+    for (const string& name : names) {
+      for (const string& precision : precisions) {
+	double fastest;
+	execution e = measure(command,{},name + " " + precision + "\n",
+			      repeat,timeout,fastest);
+
+	string evaluated = reported(e.output,"Number of boxes evaluated:");
+	string median = "null", rate = "null";
+	if (e.status == "ok") {
+	  median = json_number(e.seconds);
+	  if (evaluated != "null") {
+	    rate = json_number(stod(evaluated)/e.seconds);
+	  }
+	}
+
+	os << (first ? "" : ",\n")
+	   << "{\"engine\": \"" << engine << "\""
+	   << ", \"function\": \"" << name << "\""
+	   << ", \"precision\": " << json_number(stod(precision))
+	   << ", \"status\": \"" << e.status << "\""
+	   << ", \"seconds\": " << median
+	   << ", \"seconds_min\": "
+	   << (e.status == "ok" ? json_number(fastest) : "null")
+	   << ", \"max_rss_kb\": " << e.max_rss_kb
+	   << ", \"minimizers\": "
+	   << reported(e.output,"Number of minimizers:")
+	   << ", \"upper_bound\": "
+	   << reported(e.output,"Upper bound for minimum:")
+	   << ", \"boxes_evaluated\": " << evaluated
+	   << ", \"boxes_pruned\": "
+	   << reported(e.output,"Number of boxes pruned:")
+	   << ", \"boxes_per_second\": " << rate << "}";
+	first = false;
+	cerr << engine << " " << name << " " << precision << ": "
+	     << e.status << " " << median << " s" << endl;
+      }
+    }
+  }
+  os << "\n]}" << endl;
+}
@@ -0,0 +1,70 @@
+/*
+  Box --
+
+  Box of dimension N, i.e., the Cartesian product of N intervals, for
+  the functions of more than two variables. The intervals are stored
+  contiguously in a fixed-size array so that a box is a compact value
+  that can be copied and passed around without any allocation.
+*/
+
+#ifndef __box_h__
+#define __box_h__
+
+#include "interval.h"
+
+template<unsigned int N>
+struct box {
+  box() {}
+  // Box whose N dimensions are equal to I
+  explicit box(const interval& I)
+  {
+    for (unsigned int i = 0; i < N; ++i) {
+      v[i] = I;
+    }
+  }
+
+  const interval& operator[](unsigned int i) const { return v[i]; }
+  interval& operator[](unsigned int i) { return v[i]; }
+
+  // Index of the widest dimension
+  unsigned int widest(void) const
+  {
+    unsigned int k = 0;
+    for (unsigned int i = 1; i < N; ++i) {
+      if (v[i].width() > v[k].width()) {
+	k = i;
+      }
+    }
+    return k;
+  }
+
+  // Width of the widest dimension
+  double width(void) const
+  {
+    return v[widest()].width();
+  }
+
+  // Degenerate box reduced to the center of the box
+  box center(void) const
+  {
+    box c;
+    for (unsigned int i = 0; i < N; ++i) {
+      c.v[i] = interval(v[i].mid());
+    }
+    return c;
+  }
+
+  interval v[N];
+};
+
+// Split of b into two halves l and r along its k-th dimension
+template<unsigned int N>
+void bisect(const box<N>& b, unsigned int k, box<N>& l, box<N>& r)
+{
+  double m = b[k].mid();
+  l = r = b;
+  l[k] = interval(b[k].left(),m);
+  r[k] = interval(m,b[k].right());
+}
+
+#endif // __box_h__
@@ -0,0 +1,117 @@
+/*
+  Budget --
+
+  Time and evaluation budget of an anytime search. Once the budget is
+  exhausted, the boxes not explored yet are left aside and the search
+  returns the upper bound and the minimizers found so far. The smallest
+  lower bound of the function over the boxes left aside is kept, so
+  that the minimum is still known to lie between it (or the smallest
+  lower bound of the minimizers) and the upper bound.
+
+  The threads do not charge the shared budget at each evaluation: each
+  one counts its evaluations with its own budget_meter, which charges
+  them to the budget and reads the clock once every batch evaluations
+  only. The search may thus overrun the budget by batch evaluations
+  per thread.
+*/
+
+#ifndef __budget_h__
+#define __budget_h__
+
+#include <atomic>
+#include <chrono>
+#include <limits>
+
+class search_budget {
+public:
+  typedef std::chrono::steady_clock clock;
+
+  // Unlimited budget
+  search_budget()
+    : deadline(clock::time_point::max()),
+      max_evaluations(std::numeric_limits<unsigned long long>::max()),
+      spent(0), expired(false),
+      skipped(std::numeric_limits<double>::infinity()) {}
+
+  // The search must stop seconds from now
+  void limit_time(double seconds)
+  {
+    deadline = clock::now()
+      + std::chrono::duration_cast<clock::duration>(std::chrono::duration<double>(seconds));
+  }
+
+  // The search must stop after n evaluations
+  void limit_evaluations(unsigned long long n) { max_evaluations = n; }
+
+  // Adds n evaluations to the ones spent. Returns true if the budget
+  // is exhausted
+  bool charge(unsigned long long n)
+  {
+    if (expired.load(std::memory_order_relaxed)) {
+      return true;
+    }
+    if (spent.fetch_add(n,std::memory_order_relaxed)+n >= max_evaluations
+	|| clock::now() >= deadline) {
+      expired.store(true,std::memory_order_relaxed);
+      return true;
+    }
+    return false;
+  }
+
+  bool exhausted(void) const { return expired.load(std::memory_order_relaxed); }
+
+  // A box over which the function is at least lb is left unexplored
+  void skip(double lb)
+  {
+    double current = skipped.load(std::memory_order_relaxed);
+    while (lb < current
+	   && !skipped.compare_exchange_weak(current,lb,std::memory_order_relaxed)) {
+    }
+  }
+
+  // Smallest lower bound of the function over the boxes left
+  // unexplored (+oo if none)
+  double unexplored_bound(void) const
+  {
+    return skipped.load(std::memory_order_relaxed);
+  }
+
+private:
+  clock::time_point deadline;
+  unsigned long long max_evaluations;
+  std::atomic<unsigned long long> spent;
+  std::atomic<bool> expired;
+  std::atomic<double> skipped;
+};
+
+// Evaluations of one thread, charged to the budget by batches
+class budget_meter {
+public:
+  static const unsigned int batch = 256;
+
+  explicit budget_meter(search_budget& budget)
+    : budget(budget), count(0), stopped(budget.exhausted()) {}
+
+  ~budget_meter() { budget.charge(count); }
+
+  void spend(unsigned int n = 1)
+  {
+    count += n;
+    if (count >= batch) {
+      stopped = budget.charge(count);
+      count = 0;
+    }
+  }
+
+  // Was the budget exhausted at the last charge?
+  bool exhausted(void) const { return stopped; }
+
+  void skip(double lb) { budget.skip(lb); }
+
+private:
+  search_budget& budget;
+  unsigned int count; // Evaluations not charged yet
+  bool stopped;
+};
+
+#endif // __budget_h__
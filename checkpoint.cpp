@@ -0,0 +1,149 @@
+/*
+  Checkpoint --
+
+  Binary format (all the integers are unsigned 64-bit ones):
+    "BBCHKPT1"
+    length of the name of the function, followed by its characters
+    threshold, min_ub, parts
+    number of tasks, followed by the 4 bounds of each task
+    number of minimizers, followed by the 4 bounds, lbmin and ubmin of
+    each minimizer
+*/
+
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <stdexcept>
+#include "checkpoint.h"
+
+using namespace std;
+
+namespace {
+
+const char magic[] = "BBCHKPT1";
+
+class writer {
+public:
+  explicit writer(const string& path) : os(path,ios::binary) {}
+
+  void put(uint64_t v) { os.write(reinterpret_cast<const char*>(&v),sizeof(v)); }
+  void put(double v) { os.write(reinterpret_cast<const char*>(&v),sizeof(v)); }
+  void put(const interval& I) { put(I.left()); put(I.right()); }
+  void put(const char* s, size_t n) { os.write(s,n); }
+
+  bool good(void) { os.flush(); return bool(os); }
+
+private:
+  ofstream os;
+};
+
+class reader {
+public:
+  explicit reader(const string& path) : is(path,ios::binary), end(0)
+  {
+    if (is.seekg(0,ios::end)) {
+      end = is.tellg();
+      is.seekg(0);
+    }
+  }
+
+  uint64_t get_count(void) { uint64_t v = 0; get(v); return v; }
+  // Number of items of item_size bytes that follow. A count larger than
+  // what is left of the file, e.g., in a corrupt file, is a read error
+  // rather than a huge allocation.
+  uint64_t get_count(size_t item_size)
+  {
+    uint64_t n = get_count();
+    streamoff at = is.tellg();
+    if (!is || at > end || n > uint64_t(end-at)/item_size) {
+      is.setstate(ios::failbit);
+      return 0;
+    }
+    return n;
+  }
+  double get_double(void) { double v = 0; get(v); return v; }
+  interval get_interval(void)
+  {
+    double l = get_double();
+    double r = get_double();
+    return interval(l,r);
+  }
+  string get_string(size_t n)
+  {
+    string s(n,'\0');
+    is.read(&s[0],n);
+    return s;
+  }
+
+  bool good(void) const { return bool(is); }
+
+private:
+  template<typename T>
+  void get(T& v) { is.read(reinterpret_cast<char*>(&v),sizeof(v)); }
+
+  ifstream is;
+  streamoff end; // Size of the file
+};
+
+} // namespace
+
+void write_checkpoint(const string& path, const checkpoint& c)
+{
+  string partial = path + ".part";
+  {
+    writer w(partial);
+    w.put(magic,8);
+    w.put(uint64_t(c.function.size()));
+    w.put(c.function.data(),c.function.size());
+    w.put(c.threshold);
+    w.put(c.min_ub);
+    w.put(uint64_t(c.parts));
+    w.put(uint64_t(c.tasks.size()));
+    for (const task& t : c.tasks) {
+      w.put(t.x);
+      w.put(t.y);
+    }
+    w.put(uint64_t(c.minimizers.size()));
+    for (const minimizer& m : c.minimizers) {
+      w.put(m.xmin);
+      w.put(m.ymin);
+      w.put(m.lbmin);
+      w.put(m.ubmin);
+    }
+    if (!w.good()) {
+      throw runtime_error("Cannot write checkpoint " + partial);
+    }
+  }
+  if (rename(partial.c_str(),path.c_str()) != 0) {
+    throw runtime_error("Cannot rename checkpoint " + partial);
+  }
+}
+
+checkpoint read_checkpoint(const string& path)
+{
+  reader r(path);
+  if (r.get_string(8) != string(magic,8)) {
+    throw runtime_error("Not a checkpoint: " + path);
+  }
+  checkpoint c;
+  c.function = r.get_string(r.get_count(1));
+  c.threshold = r.get_double();
+  c.min_ub = r.get_double();
+  c.parts = r.get_count();
+  c.tasks.resize(r.get_count(4*sizeof(double)));
+  for (task& t : c.tasks) {
+    t.x = r.get_interval();
+    t.y = r.get_interval();
+  }
+  c.minimizers.resize(r.get_count(6*sizeof(double)));
+  for (minimizer& m : c.minimizers) {
+    m.xmin = r.get_interval();
+    m.ymin = r.get_interval();
+    m.lbmin = r.get_double();
+    m.ubmin = r.get_double();
+  }
+  if (!r.good()) {
+    throw runtime_error("Truncated or corrupt checkpoint: " + path);
+  }
+  return c;
+}
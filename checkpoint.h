@@ -0,0 +1,44 @@
+/*
+  Checkpoint --
+
+  State of an interrupted search, from which it can be resumed: the
+  function minimized, the threshold, the current upper bound of the
+  minimum, the boxes not explored yet and the minimizers found so far.
+  The search resumed from a checkpoint explores the boxes left with the
+  same upper bound and gives the same result as the search would have.
+
+  A checkpoint is written in a compact binary format, with the bounds
+  stored as raw doubles: it can only be read back on a machine with the
+  same representation of doubles. The file is written under another
+  name first and then renamed, so that a search interrupted while
+  writing a checkpoint leaves the previous one intact.
+*/
+
+#ifndef __checkpoint_h__
+#define __checkpoint_h__
+
+#include <string>
+#include <vector>
+#include "interval.h"
+#include "minimizer.h"
+
+// Box waiting to be explored
+struct task {
+  interval x;
+  interval y;
+};
+
+struct checkpoint {
+  std::string function; // Name in the table "functions"
+  double threshold;
+  double min_ub;
+  unsigned int parts; // Number of processes that wrote one checkpoint each
+  std::vector<task> tasks;
+  std::vector<minimizer> minimizers;
+};
+
+// Both functions throw a std::runtime_error on failure
+void write_checkpoint(const std::string& path, const checkpoint& c);
+checkpoint read_checkpoint(const std::string& path);
+
+#endif // __checkpoint_h__
@@ -0,0 +1,344 @@
+/*
+  Expression --
+
+  Expression templates over the interval class. Applied to the
+  placeholders expression::x and expression::y, a function template of
+  functions.h does not compute anything: it builds a tree of types
+  describing its expression. evaluate() then computes the expression
+  over a box in a single inlined pass in which:
+  - the powers of x and y used anywhere in the expression (including
+    x and y themselves) are computed once, beforehand;
+  - all the occurrences of x*y, including the ones scaled by a
+    constant such as 6*x*y, share the same product.
+
+  The constants remain doubles so that the operators of interval with
+  a constant operand are used.
+*/
+
+#ifndef __expression_h__
+#define __expression_h__
+
+#include "interval.h"
+
+namespace expression {
+
+// Bit masks of the powers of each variable used by an expression are
+// limited to this exponent
+const unsigned int max_exponent = 16;
+
+// Base class of all the nodes of the tree (CRTP)
+template<typename E>
+struct expr {
+  const E& self(void) const { return static_cast<const E&>(*this); }
+};
+
+// Highest exponent in a bit mask of powers
+constexpr unsigned int highest_exponent(unsigned int mask)
+{
+  return (mask <= 1) ? 0 : 1 + highest_exponent(mask >> 1);
+}
+
+// Values shared by all the subexpressions during one evaluation:
+// px[k] = x^k for each k in XMask, py[k] = y^k for each k in YMask,
+// and x*y if XY is true
+template<unsigned int XMask, unsigned int YMask, bool XY>
+struct environment {
+  environment() {}
+  // Only the powers in the masks are ever set: the members are left
+  // uninitialized instead of being set to [-inf, +inf]
+  union {
+    interval px[highest_exponent(XMask)+1];
+  };
+  union {
+    interval py[highest_exponent(YMask)+1];
+  };
+  union {
+    interval xy;
+  };
+};
+
+// Computation of v^k for all k in Mask at compile time. The even
+// powers are computed from v2 = v^2, which shares the handling of the
+// sign of v between all of them.
+template<unsigned int Mask, unsigned int K>
+struct powers_of {
+  static void compute(const interval& v, const interval& v2, interval *p)
+  {
+    powers_of<Mask,K-1>::compute(v,v2,p);
+    if (Mask & (1u << K)) {
+      p[K] = (K % 2 == 0) ? pow<K/2>(v2) : pow<K>(v);
+    }
+  }
+};
+
+template<unsigned int Mask>
+struct powers_of<Mask,0> {
+  static void compute(const interval& v, const interval& v2, interval *p) {}
+};
+
+template<unsigned int Mask>
+inline void compute_powers(const interval& v, interval *p)
+{
+  const unsigned int even_mask = 0x55555555u & ~1u;
+  interval v2 = (Mask & even_mask) ? pow<2>(v) : v;
+  powers_of<Mask,highest_exponent(Mask)>::compute(v,v2,p);
+}
+
+// Placeholder for the I-th variable (0 for x, 1 for y)
+template<unsigned int I>
+struct variable : expr<variable<I> > {
+  static constexpr unsigned int powers(unsigned int v)
+  {
+    return (v == I) ? (1u << 1) : 0;
+  }
+  static constexpr bool uses_xy(void) { return false; }
+
+  template<unsigned int XM, unsigned int YM, bool XY>
+  const interval& eval(const environment<XM,YM,XY>& env) const
+  {
+    return (I == 0) ? env.px[1] : env.py[1];
+  }
+};
+
+const variable<0> x = variable<0>();
+const variable<1> y = variable<1>();
+
+struct constant : expr<constant> {
+  explicit constant(double v) : value(v) {}
+
+  static constexpr unsigned int powers(unsigned int v) { return 0; }
+  static constexpr bool uses_xy(void) { return false; }
+
+  template<unsigned int XM, unsigned int YM, bool XY>
+  double eval(const environment<XM,YM,XY>& env) const
+  {
+    return value;
+  }
+
+  double value;
+};
+
+template<typename L, typename R>
+struct sum : expr<sum<L,R> > {
+  sum(const L& l, const R& r) : left(l), right(r) {}
+
+  static constexpr unsigned int powers(unsigned int v)
+  {
+    return L::powers(v) | R::powers(v);
+  }
+  static constexpr bool uses_xy(void)
+  {
+    return L::uses_xy() || R::uses_xy();
+  }
+
+  template<unsigned int XM, unsigned int YM, bool XY>
+  interval eval(const environment<XM,YM,XY>& env) const
+  {
+    return left.eval(env) + right.eval(env);
+  }
+
+  L left;
+  R right;
+};
+
+template<typename L, typename R>
+struct difference : expr<difference<L,R> > {
+  difference(const L& l, const R& r) : left(l), right(r) {}
+
+  static constexpr unsigned int powers(unsigned int v)
+  {
+    return L::powers(v) | R::powers(v);
+  }
+  static constexpr bool uses_xy(void)
+  {
+    return L::uses_xy() || R::uses_xy();
+  }
+
+  template<unsigned int XM, unsigned int YM, bool XY>
+  interval eval(const environment<XM,YM,XY>& env) const
+  {
+    return left.eval(env) - right.eval(env);
+  }
+
+  L left;
+  R right;
+};
+
+template<typename L, typename R>
+struct product : expr<product<L,R> > {
+  product(const L& l, const R& r) : left(l), right(r) {}
+
+  static constexpr unsigned int powers(unsigned int v)
+  {
+    return L::powers(v) | R::powers(v);
+  }
+  static constexpr bool uses_xy(void)
+  {
+    return L::uses_xy() || R::uses_xy();
+  }
+
+  template<unsigned int XM, unsigned int YM, bool XY>
+  interval eval(const environment<XM,YM,XY>& env) const
+  {
+    return left.eval(env) * right.eval(env);
+  }
+
+  L left;
+  R right;
+};
+
+// x*y is read from the environment
+template<>
+struct product<variable<0>,variable<1> >
+  : expr<product<variable<0>,variable<1> > > {
+  product(const variable<0>& l, const variable<1>& r) {}
+
+  static constexpr unsigned int powers(unsigned int v) { return 0; }
+  static constexpr bool uses_xy(void) { return true; }
+
+  template<unsigned int XM, unsigned int YM, bool XY>
+  const interval& eval(const environment<XM,YM,XY>& env) const
+  {
+    return env.xy;
+  }
+};
+
+// (c*x)*y is computed as c*(x*y) so that x*y is shared
+template<>
+struct product<product<constant,variable<0> >,variable<1> >
+  : expr<product<product<constant,variable<0> >,variable<1> > > {
+  product(const product<constant,variable<0> >& l, const variable<1>& r)
+    : factor(l.left.value) {}
+
+  static constexpr unsigned int powers(unsigned int v) { return 0; }
+  static constexpr bool uses_xy(void) { return true; }
+
+  template<unsigned int XM, unsigned int YM, bool XY>
+  interval eval(const environment<XM,YM,XY>& env) const
+  {
+    return factor * env.xy;
+  }
+
+  double factor;
+};
+
+template<typename E, unsigned int N>
+struct power : expr<power<E,N> > {
+  explicit power(const E& e) : base(e) {}
+
+  static constexpr unsigned int powers(unsigned int v)
+  {
+    return E::powers(v);
+  }
+  static constexpr bool uses_xy(void) { return E::uses_xy(); }
+
+  template<unsigned int XM, unsigned int YM, bool XY>
+  interval eval(const environment<XM,YM,XY>& env) const
+  {
+    return pow<N>(base.eval(env));
+  }
+
+  E base;
+};
+
+// Powers of a variable are read from the environment
+template<unsigned int I, unsigned int N>
+struct power<variable<I>,N> : expr<power<variable<I>,N> > {
+  static_assert(N <= max_exponent, "exponent too large");
+
+  explicit power(const variable<I>& e) {}
+
+  static constexpr unsigned int powers(unsigned int v)
+  {
+    return (v == I) ? (1u << N) : 0;
+  }
+  static constexpr bool uses_xy(void) { return false; }
+
+  template<unsigned int XM, unsigned int YM, bool XY>
+  const interval& eval(const environment<XM,YM,XY>& env) const
+  {
+    return (I == 0) ? env.px[N] : env.py[N];
+  }
+};
+
+template<typename L, typename R>
+sum<L,R> operator+(const expr<L>& l, const expr<R>& r)
+{
+  return sum<L,R>(l.self(),r.self());
+}
+
+template<typename R>
+sum<constant,R> operator+(double c, const expr<R>& r)
+{
+  return sum<constant,R>(constant(c),r.self());
+}
+
+template<typename L>
+sum<L,constant> operator+(const expr<L>& l, double c)
+{
+  return sum<L,constant>(l.self(),constant(c));
+}
+
+template<typename L, typename R>
+difference<L,R> operator-(const expr<L>& l, const expr<R>& r)
+{
+  return difference<L,R>(l.self(),r.self());
+}
+
+template<typename R>
+difference<constant,R> operator-(double c, const expr<R>& r)
+{
+  return difference<constant,R>(constant(c),r.self());
+}
+
+template<typename L>
+difference<L,constant> operator-(const expr<L>& l, double c)
+{
+  return difference<L,constant>(l.self(),constant(c));
+}
+
+template<typename L, typename R>
+product<L,R> operator*(const expr<L>& l, const expr<R>& r)
+{
+  return product<L,R>(l.self(),r.self());
+}
+
+template<typename R>
+product<constant,R> operator*(double c, const expr<R>& r)
+{
+  return product<constant,R>(constant(c),r.self());
+}
+
+template<typename L>
+product<constant,L> operator*(const expr<L>& l, double c)
+{
+  return product<constant,L>(constant(c),l.self());
+}
+
+template<unsigned int N, typename E>
+power<E,N> pow(const expr<E>& e)
+{
+  return power<E,N>(e.self());
+}
+
+// Evaluation of the expression e over the box xv*yv
+template<typename E>
+inline __attribute__((always_inline))
+interval evaluate(const expr<E>& e, const interval& xv, const interval& yv)
+{
+  const unsigned int xmask = E::powers(0);
+  const unsigned int ymask = E::powers(1);
+  static_assert(xmask < (2u << max_exponent) && ymask < (2u << max_exponent),
+		"exponent too large");
+  environment<xmask,ymask,E::uses_xy()> env;
+  compute_powers<xmask>(xv,env.px);
+  compute_powers<ymask>(yv,env.py);
+  if (E::uses_xy()) {
+    env.xy = xv*yv;
+  }
+  return e.self().eval(env);
+}
+
+} // namespace expression
+
+#endif // __expression_h__
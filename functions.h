@@ -4,10 +4,13 @@
   Some examples of functions to optimize with their known minimizer.
 
   How to add new functions:
-  1/ Add the signature to functions.h
+  1/ Add the code of the function to functions.h as a template on the
+     type of its arguments
   2/ Add the name and initial domains to the unordered_map "functions"
      at the beginning of functions.cpp
-  3/ Add the code of the function to functions.cpp
+
+  Functions of N variables are templates on N taking a box<N>. They
+  are registered once for all dimensions in functions_n().
 
   Author: Frederic Goualard <Frederic.Goualard@univ-nantes.fr>
   v. 1.0, 2013-02-15
@@ -19,37 +22,116 @@
 #include <string>
 #include <unordered_map>
 
-// Forward declaration of the interval class
-class interval;
+#include <cstddef>
+#include "interval.h"
+#include "expression.h"
+#include "gradient.h"
+#include "affine.h"
+#include "box.h"
 
 // Signature type of a binary function to minimize
 typedef interval (*itvfun)(const interval& x, const interval& y);
 
+// Signature type of a binary function evaluated with its gradient
+typedef gradient (*gradfun)(const gradient& x, const gradient& y);
+
+// Signature type of the evaluation of a binary function over n boxes at
+// once. The boxes are given as a structure of arrays: the i-th box is
+// [xl[i],xr[i]]x[yl[i],yr[i]] and its image is enclosed in [fl[i],fr[i]]
+typedef void (*itvbatchfun)(std::size_t n,
+			    const double *xl, const double *xr,
+			    const double *yl, const double *yr,
+			    double *fl, double *fr);
+
 // Type to gather the information needed to start optimizing a
 // function chosen by the user
 struct opt_fun_t {
   itvfun f;   // Pointer to the function to minimize
+  itvbatchfun fb; // Same function evaluated over many boxes
+  itvfun fe;  // Same function evaluated through expression templates
+  gradfun g;  // Same function evaluated with its gradient
+  itvfun fa;  // Same function evaluated in affine arithmetic
   interval x; // Initial domain for the 1st variable
   interval y; // Initial domain for the 2nd variable
 };
 
+// The functions are templates so that the same code is compiled for
+// one box (X = Y = interval), inlined in the loop of evaluate_batch,
+// turned into expression templates (X = expression::variable<0>,
+// Y = expression::variable<1>, see expression.h), differentiated
+// (X = Y = gradient, see gradient.h) and evaluated in affine arithmetic
+// (X = Y = affine, see affine.h).
+
 // Three hump camel --
 //   Minimum in box [-5,5]x[-5,5]: f(0,0) = 0
-interval three_hump_camel(const interval& x, const interval& y);
+template<typename X, typename Y>
+auto three_hump_camel(const X& x, const Y& y)
+{ // Function scaled by factor 600 to avoid fractional coefficients
+  return 1200*pow<2>(x)-630*pow<4>(x)+100*pow<6>(x)+x*y+pow<2>(y);
+}
 
 //  Goldstein-Price --
 //  Minimum in box [-2,2]x[-2,2]: f(0,-1) = 3
-interval goldstein_price(const interval& x, const interval& y);
+template<typename X, typename Y>
+auto goldstein_price(const X& x, const Y& y)
+{
+  return (1 + pow<2>(x+y+1)*(19-14*x+3*pow<2>(x) - 
+			    14*y+6*x*y+3*pow<2>(y)))*
+    (30+pow<2>(2*x-3*y)*(18-32*x+12*pow<2>(x)+48*y
+			-36*x*y+27*pow<2>(y)));
+}
 
 // Beale's function --
 // Minimum in box [-4.5, 4.5]x[-4.5, 4.5]: f(3,0.5) = 0
-interval beale(const interval& x, const interval& y);
+template<typename X, typename Y>
+auto beale(const X& x, const Y& y)
+{
+  return pow<2>(1.5-x+x*y)+pow<2>(2.25-x+x*pow<2>(y))+pow<2>(2.625-x+x*pow<3>(y));
+}
 
 // Booth's function --
 // Minimum in box [-10, 10]x[-10, 10]: f(1,3) = 0
-interval booth(const interval& x, const interval& y);
+template<typename X, typename Y>
+auto booth(const X& x, const Y& y)
+{
+  return pow<2>(x+2*y-7)+pow<2>(2*x+y-5);
+}
 
-#define FUNCTION_AND_NAME(n,domx,domy) {#n, opt_fun_t{n,domx,domy}}
+// Evaluation of F over n boxes (see itvbatchfun). GCC does not
+// vectorize the loop across the boxes: F<interval> is called rather
+// than inlined in it at -O2, and its operations already work on both
+// bounds at once in an SSE2 register. The searches therefore evaluate
+// one box at a time with F.
+template<interval (*F)(const interval&, const interval&)>
+void evaluate_batch(std::size_t n,
+		    const double *xl, const double *xr,
+		    const double *yl, const double *yr,
+		    double *fl, double *fr)
+{
+  for (std::size_t i = 0; i < n; ++i) {
+    interval fxy = F(interval(xl[i],xr[i]),interval(yl[i],yr[i]));
+    fl[i] = fxy.left();
+    fr[i] = fxy.right();
+  }
+}
+
+// Enclosure of F over x*y computed in affine arithmetic
+template<affine (*F)(const affine&, const affine&)>
+interval affine_enclosure(const interval& x, const interval& y)
+{
+  return F(affine::x(x),affine::y(y)).enclosure();
+}
+
+#define FUNCTION_AND_NAME(n,domx,domy)				  \
+  {#n, opt_fun_t{n<interval,interval>,					  \
+		 evaluate_batch<n<interval,interval> >,			  \
+		 [](const interval& x, const interval& y) {		  \
+		   return expression::evaluate(n(expression::x,expression::y), \
+					       x,y);			  \
+		 },							  \
+		 n<gradient,gradient>,					  \
+		 affine_enclosure<n<affine,affine> >,			  \
+		 domx,domy}}
 
 // Database of all functions to optimize with the initial box
 // in which a minimizer is sought.
@@ -57,4 +139,71 @@ interval booth(const interval& x, const interval& y);
 // a function whose name is given as a string by the user.
 extern std::unordered_map<std::string, opt_fun_t> functions;
 
+// Signature type of a function of N variables to minimize
+template<unsigned int N>
+using itvfun_n = interval (*)(const box<N>& x);
+
+// Information needed to start optimizing a function of N variables
+template<unsigned int N>
+struct opt_fun_n_t {
+  itvfun_n<N> f; // Pointer to the function to minimize
+  box<N> domain; // Initial domain
+};
+
+// Dimensions for which the functions of N variables can be chosen
+const unsigned int min_dimension = 3;
+const unsigned int max_dimension = 8;
+
+// Rosenbrock's function --
+// Minimum in box [-5,10]^N: f(1,...,1) = 0
+template<unsigned int N>
+interval rosenbrock(const box<N>& x)
+{
+  interval f(0.0);
+  for (unsigned int i = 0; i+1 < N; ++i) {
+    f = f + 100*pow<2>(x[i+1]-pow<2>(x[i])) + pow<2>(1-x[i]);
+  }
+  return f;
+}
+
+// Styblinski-Tang function --
+// Minimum in box [-5,5]^N: f(-2.903534,...,-2.903534) = -39.16617*N
+template<unsigned int N>
+interval styblinski_tang(const box<N>& x)
+{
+  interval f(0.0);
+  for (unsigned int i = 0; i < N; ++i) {
+    f = f + 0.5*(pow<4>(x[i]) - 16*pow<2>(x[i]) + 5*x[i]);
+  }
+  return f;
+}
+
+// Zakharov's function --
+// Minimum in box [-5,10]^N: f(0,...,0) = 0
+template<unsigned int N>
+interval zakharov(const box<N>& x)
+{
+  interval squares(0.0), s(0.0);
+  for (unsigned int i = 0; i < N; ++i) {
+    squares = squares + pow<2>(x[i]);
+    s = s + (0.5*(i+1))*x[i];
+  }
+  return squares + pow<2>(s) + pow<4>(s);
+}
+
+// Database of the functions of N variables, the same for all N. A
+// function is chosen by the user as its name followed by the
+// dimension, e.g., "rosenbrock-4".
+template<unsigned int N>
+const std::unordered_map<std::string, opt_fun_n_t<N> >& functions_n(void)
+{
+  static const std::unordered_map<std::string, opt_fun_n_t<N> > registry {
+    {"rosenbrock", opt_fun_n_t<N>{rosenbrock<N>,box<N>(interval(-5,10))}},
+    {"styblinski_tang",
+	opt_fun_n_t<N>{styblinski_tang<N>,box<N>(interval(-5,5))}},
+    {"zakharov", opt_fun_n_t<N>{zakharov<N>,box<N>(interval(-5,10))}}
+  };
+  return registry;
+}
+
 #endif // __functions_h__
@@ -0,0 +1,82 @@
+/*
+  Gradient --
+
+  Forward-mode automatic differentiation in interval arithmetic. A
+  gradient holds an enclosure of the value of an expression over a box
+  together with enclosures of its partial derivatives with respect to
+  x and y over the same box. Evaluating a function template of
+  functions.h on gradients seeded with gradient::x(X) and
+  gradient::y(Y) gives its natural extension and its gradient over X*Y.
+*/
+
+#ifndef __gradient_h__
+#define __gradient_h__
+
+#include "interval.h"
+
+struct gradient {
+  interval value; // Enclosure of the value
+  interval dx;    // Enclosure of the partial derivative wrt. x
+  interval dy;    // Enclosure of the partial derivative wrt. y
+
+  // Seeds for the two variables
+  static gradient x(const interval& X) { return gradient{X,1.0,0.0}; }
+  static gradient y(const interval& Y) { return gradient{Y,0.0,1.0}; }
+};
+
+inline gradient operator+(const gradient& u, const gradient& v)
+{
+  return gradient{u.value+v.value,u.dx+v.dx,u.dy+v.dy};
+}
+
+inline gradient operator-(const gradient& u, const gradient& v)
+{
+  return gradient{u.value-v.value,u.dx-v.dx,u.dy-v.dy};
+}
+
+inline gradient operator*(const gradient& u, const gradient& v)
+{
+  return gradient{u.value*v.value,
+      u.dx*v.value+u.value*v.dx,
+      u.dy*v.value+u.value*v.dy};
+}
+
+inline gradient operator+(double c, const gradient& u)
+{
+  return gradient{c+u.value,u.dx,u.dy};
+}
+
+inline gradient operator+(const gradient& u, double c)
+{
+  return gradient{u.value+c,u.dx,u.dy};
+}
+
+inline gradient operator-(const gradient& u, double c)
+{
+  return gradient{u.value-c,u.dx,u.dy};
+}
+
+inline gradient operator-(double c, const gradient& u)
+{
+  return gradient{c-u.value,-1.0*u.dx,-1.0*u.dy};
+}
+
+inline gradient operator*(double c, const gradient& u)
+{
+  return gradient{c*u.value,c*u.dx,c*u.dy};
+}
+
+inline gradient operator*(const gradient& u, double c)
+{
+  return c*u;
+}
+
+// (u^N)' = N*u^(N-1)*u'
+template<unsigned int N>
+inline gradient pow(const gradient& u)
+{
+  interval d = (N == 0) ? interval(0.0) : double(N)*pow<(N > 0) ? N-1 : 0>(u.value);
+  return gradient{pow<N>(u.value),d*u.dx,d*u.dy};
+}
+
+#endif // __gradient_h__
@@ -0,0 +1,132 @@
+/*
+  Incumbent --
+
+  Upper bound of the minimum shared by the threads of a parallel
+  search. Lowering the bound is a compare-and-swap loop that only ever
+  stores a smaller value, so that no improvement found by a thread is
+  lost. Reading it is a relaxed load: a thread that reads an outdated
+  bound only prunes less, it never discards a box it should keep.
+
+  Each thread reads the bound through its own cached_incumbent, which
+  reloads the shared value once every few reads only. That way the
+  threads do not keep pulling the cache line of the shared bound from
+  each other on every box evaluated.
+
+  A listener may be told of each new upper bound as soon as it is
+  found, e.g., to report it while the search goes on (see
+  trace_incumbent). It is called by the thread that lowered the bound.
+*/
+
+#ifndef __incumbent_h__
+#define __incumbent_h__
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <ostream>
+
+// Function called with each new upper bound of the minimum
+typedef std::function<void(double)> incumbent_listener;
+
+// Listener writing each new upper bound to os, with the time elapsed
+// since its creation. It can be called by several threads at once.
+inline incumbent_listener trace_incumbent(std::ostream& os)
+{
+  auto start = std::chrono::steady_clock::now();
+  auto lock = std::make_shared<std::mutex>();
+  return [&os,start,lock](double ub) {
+    std::lock_guard<std::mutex> guard(*lock);
+    std::chrono::duration<double> t = std::chrono::steady_clock::now()-start;
+    os << "New upper bound: " << ub << " after " << t.count() << " s"
+       << std::endl;
+  };
+}
+
+class shared_incumbent {
+public:
+  shared_incumbent(double ub = std::numeric_limits<double>::infinity())
+    : bound(ub) {}
+
+  double load(void) const
+  {
+    return bound.load(std::memory_order_relaxed);
+  }
+
+  void listen(const incumbent_listener& l) { listener = l; }
+
+  // Lowers the bound to ub if it is smaller. Returns true if it was
+  bool lower(double ub)
+  {
+    double current = load();
+    while (ub < current) {
+      // On failure, current is set to the bound stored by another thread
+      if (bound.compare_exchange_weak(current,ub,std::memory_order_relaxed)) {
+	if (listener) {
+	  listener(ub);
+	}
+	return true;
+      }
+    }
+    return false;
+  }
+
+private:
+  // Alone on its cache line so that updating it does not invalidate
+  // unrelated data
+  alignas(64) std::atomic<double> bound;
+  char padding[64-sizeof(std::atomic<double>)];
+  incumbent_listener listener;
+};
+
+class cached_incumbent {
+public:
+  // The shared bound is reloaded once every refresh reads
+  explicit cached_incumbent(shared_incumbent& shared, unsigned int refresh = 16)
+    : shared(shared), refresh(refresh), reads(0), cached(shared.load()) {}
+
+  // Bound as known by the thread. It is never smaller than the shared
+  // one.
+  double load(void)
+  {
+    if (++reads >= refresh) {
+      reads = 0;
+      cached = shared.load();
+    }
+    return cached;
+  }
+
+  // Current value of the shared bound, which is cached as well
+  double latest(void)
+  {
+    reads = 0;
+    cached = shared.load();
+    return cached;
+  }
+
+  // Lowers both the cached and the shared bounds to ub if it is
+  // smaller. Returns true if the shared bound was lowered
+  bool lower(double ub)
+  {
+    if (ub >= cached) {
+      return false;
+    }
+    if (shared.lower(ub)) {
+      cached = ub;
+      return true;
+    }
+    // Another thread found a better bound in the meantime
+    cached = shared.load();
+    return false;
+  }
+
+private:
+  shared_incumbent& shared;
+  unsigned int refresh;
+  unsigned int reads;
+  double cached;
+};
+
+#endif // __incumbent_h__
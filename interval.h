@@ -16,6 +16,10 @@
 
 #include <iosfwd>
 #include <limits>
+#include <emmintrin.h>
+#ifdef INTERVAL_SWITCH_ROUNDING
+#   include <fenv.h>
+#endif
 
 class interval {
  public:
@@ -27,9 +31,9 @@ class interval {
   interval(double l, double r);
 
   // Left bound
-  const double left(void) const;
+  double left(void) const;
   // Right bound
-  const double right(void) const;
+  double right(void) const;
   // Width (right-left) of the interval
   double width(void) const;
   // Midpoint of the interval
@@ -38,19 +42,367 @@ class interval {
   // Is the interval empty?
   bool empty() const;
 
+  friend interval operator+(const interval& I1, const interval& I2);
+  friend interval operator-(const interval& I1, const interval& I2);
+  friend interval operator*(const interval& I1, const interval& I2);
+  friend interval operator+(double c, const interval& I);
+  friend interval operator-(const interval& I, double c);
+  friend interval operator-(double c, const interval& I);
+  friend interval operator*(double c, const interval& I);
+  friend interval pow(const interval& I, unsigned int n);
+  template<unsigned int N> friend interval pow(const interval& I);
+
 private:
-  double& lb(void);
-  double& rb(void);
-  double bounds[2];
+  // Interval from its packed representation (-l, r)
+  explicit interval(__m128d nlr);
+  // Negated left bound and right bound packed in one SSE2 register
+  __m128d bounds;
+};
+
+// Sets the rounding direction of the FPU upward for the lifetime of
+// the object and restores the previous one on destruction. The
+// interval operators are only rigorous within the scope of such an
+// object, which should therefore enclose the whole computation
+// (e.g., a complete call to minimize) in each thread.
+// When compiled with INTERVAL_SWITCH_ROUNDING, each operator switches
+// the rounding direction by itself and this class does nothing.
+class upward_rounding {
+ public:
+  upward_rounding();
+  ~upward_rounding();
+
+ private:
+  upward_rounding(const upward_rounding&);
+  upward_rounding& operator=(const upward_rounding&);
+  int previous;
 };
 
 interval operator+(const interval& I1, const interval& I2);
 interval operator-(const interval& I1, const interval& I2);
 interval operator*(const interval& I1, const interval& I2);
 
+// Operators with a constant operand. They avoid turning the constant into
+// a point interval and going through the general operators.
+interval operator+(double c, const interval& I);
+interval operator+(const interval& I, double c);
+interval operator-(const interval& I, double c);
+interval operator-(double c, const interval& I);
+interval operator*(double c, const interval& I);
+interval operator*(const interval& I, double c);
+
+// I^n computed by repeated squaring
 interval pow(const interval& I, unsigned int n);
+// I^N with an exponent known at compile time
+template<unsigned int N> interval pow(const interval& I);
 
 // Output
 std::ostream& operator<<(std::ostream& os, const interval& I);
 
+// The constructors, accessors and arithmetic operators are defined inline
+// so that a whole function evaluation can be inlined and scheduled at once.
+
+// The bounds are stored as (-left, right) in an SSE2 register so that
+// both of them are rounded upward by the same vector instruction.
+
+inline interval::interval() 
+  : bounds(_mm_set1_pd(std::numeric_limits<double>::infinity()))
+{
+}
+
+inline interval::interval(double v) 
+  : bounds(_mm_set_pd(v,-v))
+{
+}
+
+inline interval::interval(double l, double r)
+  : bounds(_mm_set_pd(r,-l))
+{
+}
+
+inline interval::interval(__m128d nlr)
+  : bounds(nlr)
+{
+}
+
+inline double interval::left(void) const
+{
+  return -_mm_cvtsd_f64(bounds);
+}
+
+inline double interval::right(void) const
+{
+  return _mm_cvtsd_f64(_mm_unpackhi_pd(bounds,bounds));
+}
+
+inline bool interval::empty() const
+{
+  return left() > right();
+}
+
+// The operators below assume that the FPU rounds upward (see
+// upward_rounding). Since the left bound is stored negated, rounding
+// it upward is the same as rounding the actual left bound downward.
+// This requires the compiler not to simplify negations (-frounding-math).
+
+namespace interval_detail {
+
+#ifdef INTERVAL_SWITCH_ROUNDING
+// Former behavior, kept for comparison purposes (see bench-interval.cpp):
+// the rounding direction is switched at each operation. GCC does not
+// see that fesetround changes the result of the SSE operations and may
+// move them across its calls, so each operator passes its operands
+// through operand() and its result through result(): the empty asm
+// statements make the operands appear to be modified once the direction
+// is upward, and the result to be read before it is restored.
+struct operation_rounding {
+  operation_rounding() { fesetround(FE_UPWARD); }
+  ~operation_rounding() { fesetround(FE_TONEAREST); }
+  __m128d operand(__m128d v) const
+  {
+    asm volatile("" : "+x"(v));
+    return v;
+  }
+  __m128d result(__m128d v) const
+  {
+    asm volatile("" : "+x"(v));
+    return v;
+  }
+};
+#else
+struct operation_rounding {
+  operation_rounding() {}
+  __m128d operand(__m128d v) const { return v; }
+  __m128d result(__m128d v) const { return v; }
+};
+#endif // INTERVAL_SWITCH_ROUNDING
+
+// Swap the two halves of an SSE2 register
+inline __m128d swap(__m128d v)
+{
+  return _mm_shuffle_pd(v,v,1);
+}
+
+// Product of two packed bounds. A bound 0 times an infinite one gives
+// NaN, which _mm_max_pd would return or drop depending on its position.
+// The bound of x*y there is 0 (x*y tends to 0 as x tends to 0 for any
+// y), so with Unbounded, NaN is replaced by 0: the bounds themselves are
+// never NaN, and an infinite product comes from another pair of bounds.
+template<bool Unbounded>
+inline __m128d mul_bound(__m128d a, __m128d b)
+{
+  __m128d m = _mm_mul_pd(a,b);
+  return Unbounded ? _mm_andnot_pd(_mm_cmpunord_pd(m,m),m) : m;
+}
+
+// Does one of the packed intervals a and b have an infinite bound? For
+// nonempty intervals, -l or r is then +inf.
+inline bool unbounded(__m128d a, __m128d b)
+{
+  __m128d m = _mm_max_pd(a,b);
+  return _mm_movemask_pd(_mm_cmpeq_pd(m,_mm_set1_pd(std::numeric_limits<double>::infinity())));
+}
+
+// Product of the packed intervals a = (nl1, r1) and b = (nl2, r2): the
+// negated left bound is the max of (nl1*r2, r1*nl2, -nl1*nl2, -r1*r2)
+// and the right bound is the max of (nl1*nl2, r1*r2, -nl1*r2, -r1*nl2),
+// all rounded upward. The products 0*inf are only looked for when a
+// bound is infinite (see operator*).
+template<bool Unbounded>
+inline __m128d product(__m128d a, __m128d b)
+{
+  __m128d nl1 = _mm_unpacklo_pd(a,a);
+  __m128d r1 = _mm_unpackhi_pd(a,a);
+  __m128d s2 = swap(b);
+  __m128d p = mul_bound<Unbounded>(nl1,s2);
+  __m128d q = mul_bound<Unbounded>(r1,b);
+  __m128d u = mul_bound<Unbounded>(_mm_xor_pd(nl1,_mm_set1_pd(-0.0)),b);
+  __m128d v = mul_bound<Unbounded>(_mm_xor_pd(r1,_mm_set1_pd(-0.0)),s2);
+  return _mm_max_pd(_mm_max_pd(p,q),_mm_max_pd(u,v));
+}
+
+// product<true>, out of line so as not to weigh on the inlined
+// evaluations of the functions (defined in interval.cpp)
+__m128d unbounded_product(__m128d a, __m128d b);
+
+// Product of packed intervals (-l, r) whose halves have the signs they
+// would have for nonnegative intervals, or that are both nonnegative.
+// Each half of a is multiplied by the magnitude of the same half of b,
+// which rounds [l1*l2, r1*r2] outward.
+inline __m128d mul_magnitude(__m128d a, __m128d b)
+{
+  return _mm_mul_pd(a,_mm_andnot_pd(_mm_set1_pd(-0.0),b));
+}
+
+// Repeated squaring of a packed interval suitable for mul_magnitude
+template<unsigned int N>
+struct power {
+  static __m128d of(__m128d w)
+  {
+    __m128d h = power<N/2>::of(w);
+    h = mul_magnitude(h,h);
+    return (N % 2) ? mul_magnitude(h,w) : h;
+  }
+};
+
+template<>
+struct power<1> {
+  static __m128d of(__m128d w) { return w; }
+};
+
+template<>
+struct power<0> {
+  static __m128d of(__m128d w) { return _mm_set_pd(1.0,-1.0); }
+};
+
+inline __m128d power_of(__m128d w, unsigned int n)
+{
+  if (n == 0) {
+    return power<0>::of(w);
+  }
+  unsigned int bit = 1;
+  while (bit <= n/2) {
+    bit <<= 1;
+  }
+  __m128d p = w;
+  for (bit >>= 1; bit != 0; bit >>= 1) {
+    p = mul_magnitude(p,p);
+    if (n & bit) {
+      p = mul_magnitude(p,w);
+    }
+  }
+  return p;
+}
+
+// Operand of mul_magnitude for an even power of the packed interval v:
+// the interval of the magnitudes of the elements of v
+inline __m128d even_power_operand(__m128d v)
+{
+  double nl = _mm_cvtsd_f64(v);
+  double r = _mm_cvtsd_f64(_mm_unpackhi_pd(v,v));
+  if (nl <= 0) { // v is nonnegative?
+    return v;
+  }
+  if (r <= 0) { // v is nonpositive?
+    return swap(v);
+  }
+  return _mm_set_pd((nl >= r) ? nl : r,0.0);
+}
+
+} // namespace interval_detail
+
+inline interval operator+(const interval& I1, const interval& I2)
+{
+  interval_detail::operation_rounding rounding;
+  // (-l1 + -l2, r1 + r2)
+  return interval(rounding.result(_mm_add_pd(rounding.operand(I1.bounds),
+					     rounding.operand(I2.bounds))));
+}
+
+inline interval operator-(const interval& I1, const interval& I2)
+{
+  interval_detail::operation_rounding rounding;
+  // (-l1 + r2, r1 + -l2)
+  __m128d s2 = interval_detail::swap(rounding.operand(I2.bounds));
+  return interval(rounding.result(_mm_add_pd(rounding.operand(I1.bounds),s2)));
+}
+
+inline interval operator*(const interval& I1, const interval& I2)
+{
+  using namespace interval_detail;
+  operation_rounding rounding;
+  __m128d a = rounding.operand(I1.bounds);
+  __m128d b = rounding.operand(I2.bounds);
+  // The bounds are finite but for the initial boxes of some problems:
+  // the test is cheaper than filtering the products each time
+  if (__builtin_expect(unbounded(a,b),0)) {
+    return interval(rounding.result(unbounded_product(a,b)));
+  }
+  return interval(rounding.result(product<false>(a,b)));
+}
+
+inline interval operator+(double c, const interval& I)
+{
+  interval_detail::operation_rounding rounding;
+  // (-l + -c, r + c)
+  return interval(rounding.result(_mm_add_pd(rounding.operand(I.bounds),
+					     _mm_set_pd(c,-c))));
+}
+
+inline interval operator+(const interval& I, double c)
+{
+  return c + I;
+}
+
+inline interval operator-(const interval& I, double c)
+{
+  interval_detail::operation_rounding rounding;
+  // (-l + c, r + -c)
+  return interval(rounding.result(_mm_add_pd(rounding.operand(I.bounds),
+					     _mm_set_pd(-c,c))));
+}
+
+inline interval operator-(double c, const interval& I)
+{
+  interval_detail::operation_rounding rounding;
+  // (r + -c, -l + c)
+  __m128d s = interval_detail::swap(rounding.operand(I.bounds));
+  return interval(rounding.result(_mm_add_pd(s,_mm_set_pd(c,-c))));
+}
+
+inline interval operator*(double c, const interval& I)
+{
+  interval_detail::operation_rounding rounding;
+  if (c == 0) { // 0 even if I is unbounded (see mul_bound)
+    return interval(0.0);
+  }
+  __m128d v = rounding.operand(I.bounds);
+  if (c > 0) { // (-l*c, r*c)
+    return interval(rounding.result(_mm_mul_pd(v,_mm_set1_pd(c))));
+  }
+  // (r*-c, -l*-c)
+  return interval(rounding.result(_mm_mul_pd(interval_detail::swap(v),
+					     _mm_set1_pd(-c))));
+}
+
+inline interval operator*(const interval& I, double c)
+{
+  return c * I;
+}
+
+// The powers are computed on bounds of the same sign so that each
+// product of the repeated squaring rounds outward (see mul_magnitude).
+// An even power is computed on the magnitudes of the elements of I. An
+// odd power is increasing and computed on I if its right bound is
+// positive (with l < 0, -l and r are both positive and their powers give
+// -l^N and r^N), and on -I otherwise.
+
+inline interval pow(const interval& I, unsigned int n)
+{
+  using namespace interval_detail;
+  operation_rounding rounding;
+  __m128d v = rounding.operand(I.bounds);
+  if (n % 2 == 0) {
+    return interval(rounding.result(power_of(even_power_operand(v),n)));
+  }
+  if (I.right() <= 0) {
+    return interval(rounding.result(swap(power_of(swap(v),n))));
+  }
+  return interval(rounding.result(power_of(v,n)));
+}
+
+template<unsigned int N>
+inline interval pow(const interval& I)
+{
+  using namespace interval_detail;
+  operation_rounding rounding;
+  __m128d v = rounding.operand(I.bounds);
+  if (N % 2 == 0) {
+    return interval(rounding.result(power<N>::of(even_power_operand(v))));
+  }
+  if (I.right() <= 0) {
+    return interval(rounding.result(swap(power<N>::of(swap(v)))));
+  }
+  return interval(rounding.result(power<N>::of(v)));
+}
+
 #endif // __interval_h__
@@ -9,6 +9,9 @@
 */
 
 #include <iostream>
+#include <cmath>
+#include <cstdint>
+#include <unordered_map>
 #include <boost/format.hpp>
 #include "interval.h"
 #include "minimizer.h"
@@ -21,3 +24,96 @@ ostream& operator<<(ostream& os, const minimizer& m)
     % m.xmin % m.ymin % m.lbmin % m.ubmin;
   return os;
 }
+
+namespace {
+
+// Union-find forest over the indices of the minimizers
+size_t find_root(vector<size_t>& parent, size_t i)
+{
+  while (parent[i] != i) {
+    parent[i] = parent[parent[i]];
+    i = parent[i];
+  }
+  return i;
+}
+
+bool touching(const minimizer& m1, const minimizer& m2)
+{
+  return m1.xmin.left() <= m2.xmin.right() && m2.xmin.left() <= m1.xmin.right()
+    && m1.ymin.left() <= m2.ymin.right() && m2.ymin.left() <= m1.ymin.right();
+}
+
+} // namespace
+
+// The minimizers are hashed into a grid whose cells are as large as the
+// widest box, according to the lower left corner of their boxes. A box
+// can then only touch the boxes of its cell and of the eight cells
+// around it, so that clustering is linear in the number of minimizers.
+vector<minimizer> cluster_minimizers(const minimizer_list& ml)
+{
+  vector<minimizer> boxes(ml.begin(),ml.end());
+  vector<minimizer> clusters;
+  if (boxes.empty()) {
+    return clusters;
+  }
+
+  double x0 = boxes[0].xmin.left(), y0 = boxes[0].ymin.left();
+  double h = 0.0;
+  for (const minimizer& m : boxes) {
+    x0 = min(x0,m.xmin.left());
+    y0 = min(y0,m.ymin.left());
+    h = max(h,max(m.xmin.width(),m.ymin.width()));
+  }
+  if (h == 0.0) { // Only degenerate boxes
+    h = 1.0;
+  }
+
+  auto cell = [&](const minimizer& m) {
+    return make_pair(int64_t(floor((m.xmin.left()-x0)/h)),
+		     int64_t(floor((m.ymin.left()-y0)/h)));
+  };
+  auto key = [](int64_t i, int64_t j) {
+    return uint64_t(i) << 32 ^ uint64_t(j);
+  };
+
+  vector<size_t> parent(boxes.size());
+  unordered_map<uint64_t,vector<size_t>> grid;
+  for (size_t k = 0; k < boxes.size(); ++k) {
+    parent[k] = k;
+    auto c = cell(boxes[k]);
+    for (int64_t i = c.first-1; i <= c.first+1; ++i) {
+      for (int64_t j = c.second-1; j <= c.second+1; ++j) {
+	auto neighbours = grid.find(key(i,j));
+	if (neighbours == grid.end()) {
+	  continue;
+	}
+	for (size_t n : neighbours->second) {
+	  if (touching(boxes[k],boxes[n])) {
+	    parent[find_root(parent,n)] = find_root(parent,k);
+	  }
+	}
+      }
+    }
+    grid[key(c.first,c.second)].push_back(k);
+  }
+
+  // Hull and bounds of the members of each cluster
+  unordered_map<size_t,size_t> index; // Root -> index in clusters
+  for (size_t k = 0; k < boxes.size(); ++k) {
+    const minimizer& m = boxes[k];
+    auto found = index.emplace(find_root(parent,k),clusters.size());
+    if (found.second) {
+      clusters.push_back(m);
+      continue;
+    }
+    minimizer& c = clusters[found.first->second];
+    c.xmin = interval(min(c.xmin.left(),m.xmin.left()),
+		      max(c.xmin.right(),m.xmin.right()));
+    c.ymin = interval(min(c.ymin.left(),m.ymin.left()),
+		      max(c.ymin.right(),m.ymin.right()));
+    c.lbmin = min(c.lbmin,m.lbmin);
+    c.ubmin = min(c.ubmin,m.ubmin);
+  }
+  sort(clusters.begin(),clusters.end(),less_minimizer());
+  return clusters;
+}
@@ -17,7 +17,10 @@
 #define __minimizer_h__
 
 #include <iosfwd>
-#include <set>
+#include <vector>
+#include <algorithm>
+#include <limits>
+#include "arena.h"
 
 class interval;
 
@@ -28,17 +31,132 @@ struct minimizer {
   double ubmin;
 };
 
+// Minimizer of a function of N variables: the box xmin replaces the
+// intervals xmin and ymin
+template<unsigned int N> struct box;
+
+template<unsigned int N>
+struct minimizer_n {
+  box<N> xmin;
+  double lbmin;
+  double ubmin;
+};
+
+// Strict weak ordering of the minimizers by increasing lower bound
 struct less_minimizer {
-  bool operator()(const minimizer& m1, const minimizer& m2) const
+  template<typename M>
+  bool operator()(const M& m1, const M& m2) const
   {
-    return m1.lbmin <= m2.lbmin;
+    return m1.lbmin < m2.lbmin;
   }
 };
 
 std::ostream& operator<<(std::ostream& os, const minimizer& m);
 
-// Set of minimizers sorted in increasing value of the lower bound of
-// the minimum.
-typedef std::multiset<minimizer,less_minimizer> minimizer_list;
+// Store of the minimizers M (minimizer or minimizer_n<N>). The
+// minimizers are appended to an arena_array, whose chunks are released
+// as the store shrinks. Lowering the upper bound of the
+// minimum does not remove anything at once: the minimizers whose lower
+// bound is greater than the bound are dropped in batches, once the
+// store has doubled in size since the last batch, and when the store
+// is read. The minimizers are sorted by increasing lower bound only
+// when sort() is called, once the search is over.
+template<typename M>
+class minimizer_store {
+public:
+  typedef typename arena_array<M>::const_iterator const_iterator;
+
+  minimizer_store()
+    : bound(std::numeric_limits<double>::infinity()), compact_at(min_compact),
+      removed(0)
+  {}
+
+  void insert(const M& m)
+  {
+    items.push_back(m);
+    if (items.size() >= compact_at) {
+      compact();
+    }
+  }
+
+  // Appends the minimizers of other. The minimizers removed from other
+  // so far are counted as removed from the store from now on
+  void merge(minimizer_store& other)
+  {
+    other.compact();
+    for (const M& m : other.items) {
+      items.push_back(m);
+    }
+    removed += other.removed;
+    other.removed = 0;
+    bound = std::min(bound,other.bound);
+    if (items.size() >= compact_at) {
+      compact();
+    }
+  }
+
+  // Removes all the minimizers. The bound is kept
+  void clear(void)
+  {
+    items.clear();
+    compact_at = min_compact;
+  }
+
+  // Discards all the minimizers whose lower bound is greater than ub
+  void discard_above(double ub)
+  {
+    bound = std::min(bound,ub);
+  }
+
+  // Removal of the minimizers discarded so far
+  void compact(void)
+  {
+    double ub = bound;
+    std::size_t before = items.size();
+    items.remove_if([ub](const M& m) { return m.lbmin > ub; });
+    removed += before - items.size();
+    compact_at = std::max(min_compact,2*items.size());
+  }
+
+  std::size_t size(void)
+  {
+    compact();
+    return items.size();
+  }
+
+  // Number of minimizers removed by the compactions so far
+  std::size_t erased(void) const { return removed; }
+
+  void sort(void)
+  {
+    compact();
+    std::sort(items.begin(),items.end(),less_minimizer());
+  }
+
+  const_iterator begin(void) const { return items.begin(); }
+  const_iterator end(void) const { return items.end(); }
+
+private:
+  static const std::size_t min_compact = 1024;
+
+  arena_array<M> items;
+  double bound; // No minimizer with a larger lower bound is kept
+  std::size_t compact_at; // Size of the next compaction
+  std::size_t removed; // Minimizers removed by compact()
+};
+
+typedef minimizer_store<minimizer> minimizer_list;
+
+template<unsigned int N>
+using minimizer_list_n = minimizer_store<minimizer_n<N> >;
+
+// Clusters of the minimizers of ml, which must have been compacted
+// (see sort()). Minimizers whose boxes touch, possibly through other
+// minimizers, belong to the same cluster. A cluster is returned as a
+// minimizer whose box is the hull of the boxes of its members and whose
+// bounds are the smallest lower bound and the smallest upper bound of
+// its members: the minimum of the function over the members lies in
+// [lbmin, ubmin]. The clusters are sorted by increasing lower bound.
+std::vector<minimizer> cluster_minimizers(const minimizer_list& ml);
 
 #endif // __minimizer_h__
@@ -11,12 +11,15 @@
 #include <iterator>
 #include <string>
 #include <stdexcept>
+#include <vector>
 #include "interval.h"
 #include "functions.h"
 #include "minimizer.h"
-#if _OPENMP
-#   include <omp.h>
-#endif
+#include "incumbent.h"
+#include "checkpoint.h"
+#include "budget.h"
+#include "work_stealing.h"
+#include "stats.h"
 #include <mpi.h>
 #include <string.h>
 
@@ -31,73 +34,6 @@ int cpt = 1;
 // Name of the function to optimize
 char choice_fun[50];
 
-// Split a 2D box into four subboxes by splitting each dimension
-// into two equal subparts
-void split_box(const interval& x, const interval& y,
-	       interval &xl, interval& xr, interval& yl, interval& yr)
-{
-  double xm = x.mid();
-  double ym = y.mid();
-  xl = interval(x.left(),xm);
-  xr = interval(xm,x.right());
-  yl = interval(y.left(),ym);
-  yr = interval(ym,y.right());
-}
-
-// Branch-and-bound minimization algorithm
-void minimize(itvfun f,  // Function to minimize
-	      const interval& x, // Current bounds for 1st dimension
-	      const interval& y, // Current bounds for 2nd dimension
-	      double threshold,  // Threshold at which we should stop splitting
-	      double& min_ub,  // Current minimum upper bound
-	      minimizer_list& ml) // List of current minimizers
-{
-  interval fxy = f(x,y);
-     
-  if (fxy.left() > min_ub) { // Current box cannot contain minimum?
-    return ;
-  }
-
-  if (fxy.right() < min_ub) { // Current box contains a new minimum?
-    min_ub = fxy.right();
-    // Discarding all saved boxes whose minimum lower bound is 
-    // greater than the new minimum upper bound
-    auto discard_begin = ml.lower_bound(minimizer{0,0,min_ub,0});
-	
-		#pragma  omp critical 
-		ml.erase(discard_begin,ml.end());
-  }
-
-  // Checking whether the input box is small enough to stop searching.
-  // We can consider the width of one dimension only since a box
-  // is always split equally along both dimensions
-  if (x.width() <= threshold) { 
-    // We have potentially a new minimizer
-	 	#pragma  omp critical 
-    ml.insert(minimizer{x,y,fxy.left(),fxy.right()});
-    
-    return ;
-  }
-
-  // The box is still large enough => we split it into 4 sub-boxes
-  // and recursively explore them
-  interval xl, xr, yl, yr;
-  split_box(x,y,xl,xr,yl,yr);
-
-  #pragma omp parallel  
-	#pragma omp sections
-	{
-		#pragma omp section
-		minimize(f,xl,yl,threshold,min_ub,ml);
-		#pragma omp section
-		minimize(f,xl,yr,threshold,min_ub,ml);
-		#pragma omp section
-		minimize(f,xr,yl,threshold,min_ub,ml);
-		#pragma omp section
-		minimize(f,xr,yr,threshold,min_ub,ml);
-  }
-}
-
 void MPI_Send_Interval(const interval & x, const interval & y, double threshold, double min_ub) {
 	double envoie_inter_thres_min[6] = {x.left(),x.right(),y.left(),y.right(),threshold,min_ub};
 	MPI_Send(&choice_fun,50,MPI_CHAR,cpt,0,MPI_COMM_WORLD);
@@ -119,15 +55,20 @@ void MPI_Recv_Interval(itvfun & f, interval & x, interval & y, double& threshold
 
   fun = functions.at(recv_fun);
 	f = fun.f;
+	strcpy(choice_fun,recv_fun);
 }
 
-// Branch-and-bound minimization algorithm
+// Branch-and-bound minimization algorithm sending subboxes to the
+// other processors as long as some are idle. The boxes left to the
+// current processor are saved in local, to be explored by its threads
+// (see work_stealing_search)
 void minimize_mpi(itvfun f,  // Function to minimize
 	      const interval& x, // Current bounds for 1st dimension
 	      const interval& y, // Current bounds for 2nd dimension
 	      double threshold,  // Threshold at which we should stop splitting
 	      double& min_ub,  // Current minimum upper bound
-	      minimizer_list& ml) // List of current minimizers
+	      minimizer_list& ml, // List of current minimizers
+	      vector<task>& local) // Boxes left to the current processor
 {
   interval fxy = f(x,y);
      
@@ -139,16 +80,13 @@ void minimize_mpi(itvfun f,  // Function to minimize
     min_ub = fxy.right();
     // Discarding all saved boxes whose minimum lower bound is 
     // greater than the new minimum upper bound
-    auto discard_begin = ml.lower_bound(minimizer{0,0,min_ub,0});
-	
 		#pragma  omp critical 
-		ml.erase(discard_begin,ml.end());
+		ml.discard_above(min_ub);
   }
 
   // Checking whether the input box is small enough to stop searching.
-  // We can consider the width of one dimension only since a box
-  // is always split equally along both dimensions
-  if (x.width() <= threshold) { 
+  // Both widths are tested since the domain need not be square
+  if (x.width() <= threshold && y.width() <= threshold) { 
     // We have potentially a new minimizer
 	 	#pragma  omp critical 
     ml.insert(minimizer{x,y,fxy.left(),fxy.right()});
@@ -165,31 +103,90 @@ void minimize_mpi(itvfun f,  // Function to minimize
 		MPI_Send_Interval( xl, yl, threshold, min_ub);
 		++cpt;
 	} else {
-		minimize(f,xl,yl,threshold,min_ub,ml);
+		local.push_back(task{xl,yl});
 	}
 	
 	if(cpt < numprocs) {
 		MPI_Send_Interval( xl, yr,threshold,min_ub);
 		++cpt;
 	} else {
-		minimize(f,xl,yr,threshold,min_ub,ml);
+		local.push_back(task{xl,yr});
 	}
 
 	if(cpt < numprocs) {
 		MPI_Send_Interval(xr, yl,threshold,min_ub);
 		++cpt;
 	} else {
-		minimize(f,xr,yl,threshold,min_ub,ml);
+		local.push_back(task{xr,yl});
 	}
 
 	if(cpt < numprocs) {
-		minimize_mpi(f,xr,yr,threshold,min_ub,ml);
+		minimize_mpi(f,xr,yr,threshold,min_ub,ml,local);
 	} else {
-		minimize(f,xr,yr,threshold,min_ub,ml);
+		local.push_back(task{xr,yr});
 	}
 }
 
+// Budget of the current processor, and its limits given on the
+// command line (0: none)
+search_budget budget;
+double time_limit = 0;
+unsigned long long max_evaluations = 0;
+// Told of each new upper bound found by the current processor, if set
+incumbent_listener on_new_upper_bound;
+// Counters of the threads of the current processor, added up
+search_stats local_stats;
+
+// Search of the boxes tasks by the threads of the current processor,
+// writing a checkpoint to checkpoint_file.<rank> every checkpoint_period
+// seconds if checkpoint_file is not empty
+void minimize_local(itvfun f, const vector<task>& tasks, double threshold,
+		    double& min_ub, minimizer_list& ml,
+		    const string& checkpoint_file, double checkpoint_period)
+{
+	shared_incumbent ub(min_ub);
+	if (on_new_upper_bound) {
+		ub.listen(on_new_upper_bound);
+	}
+	// The time limit counts from now on, once the input has been read and
+	// the boxes distributed, as in optimization-seq and optimization-omp
+	if (time_limit > 0) {
+		budget.limit_time(time_limit);
+	}
+	if (max_evaluations > 0) {
+		budget.limit_evaluations(max_evaluations);
+	}
+	work_stealing_search search(f,threshold,ub,ml,omp_get_max_threads());
+	search.limit(budget);
+	if (!checkpoint_file.empty()) {
+		search.checkpoint_to(checkpoint_file + "." + to_string(rang),
+				     checkpoint_period,choice_fun,numprocs);
+	}
+	search.run(tasks);
+	min_ub = ub.load();
+	local_stats = search.stats();
+}
 
+
+// Usage: optimization-mpi [--checkpoint=FILE]
+//                         [--checkpoint-period=SECONDS] [--resume=FILE]
+//                         [--time-limit=SECONDS] [--max-evaluations=N]
+//                         [--trace-incumbent] [--stats[=json]]
+//   --checkpoint: each processor writes a checkpoint of its part of
+//                 the search to FILE.<rank> every SECONDS seconds
+//                 (default: 60)
+//   --resume: resume the search from the checkpoints FILE.<rank>,
+//             which requires as many processors as when they were
+//             written
+//   --time-limit, --max-evaluations: each processor stops exploring
+//             boxes after SECONDS seconds or N evaluations of the
+//             function (see search_budget)
+//   --trace-incumbent: write each new upper bound found by a processor
+//             to the standard error as soon as it is found
+//   --stats: display the counters of each processor, summed over its
+//            threads, and their sum (see search_stats), as text or as
+//            JSON. They are not available if the program was compiled
+//            with SEARCH_STATS=0
 int main(int argc, char *argv[])
 {
   cout.precision(16);
@@ -208,7 +205,67 @@ int main(int argc, char *argv[])
 	MPI_Comm_rank(MPI_COMM_WORLD,&rang);
 	MPI_Comm_size(MPI_COMM_WORLD, &numprocs);
 
-	if(rang == 0) {
+	string checkpoint_file, resume_file;
+	double checkpoint_period = 60;
+	bool stats = false, stats_json = false;
+	for (int i = 1; i < argc; ++i) {
+		string option(argv[i]);
+		if (option.compare(0,13,"--checkpoint=") == 0) {
+			checkpoint_file = option.substr(13);
+		} else if (option.compare(0,20,"--checkpoint-period=") == 0) {
+			checkpoint_period = stod(option.substr(20));
+		} else if (option.compare(0,9,"--resume=") == 0) {
+			resume_file = option.substr(9);
+		} else if (option.compare(0,13,"--time-limit=") == 0) {
+			time_limit = stod(option.substr(13));
+		} else if (option.compare(0,18,"--max-evaluations=") == 0) {
+			max_evaluations = stoull(option.substr(18));
+		} else if (option == "--trace-incumbent") {
+			on_new_upper_bound = trace_incumbent(cerr);
+		} else if (option == "--stats" || option == "--stats=json") {
+			stats = true;
+			stats_json = (option == "--stats=json");
+		} else {
+			if (rang == 0) {
+				cerr << "Unknown option: " << argv[i] << endl;
+			}
+			MPI_Finalize();
+			return 1;
+		}
+	}
+	if (stats && !SEARCH_STATS) {
+		if (rang == 0) {
+			cerr << "No statistics: compiled with SEARCH_STATS=0" << endl;
+		}
+		stats = false;
+	}
+
+	if (!resume_file.empty()) {
+		// Each processor resumes its own part of the search
+		checkpoint resumed;
+		opt_fun_t fun;
+		try {
+			resumed = read_checkpoint(resume_file + "." + to_string(rang));
+			if (resumed.parts != unsigned(numprocs)) {
+				throw runtime_error("The checkpoint was written by "
+						    + to_string(resumed.parts) + " processors");
+			}
+			fun = functions.at(resumed.function);
+		} catch (exception& e) {
+			cerr << e.what() << endl;
+			MPI_Abort(MPI_COMM_WORLD,1);
+			return 1;
+		}
+		strncpy(choice_fun,resumed.function.c_str(),sizeof(choice_fun)-1);
+		min_ub = resumed.min_ub;
+		for (const minimizer& m : resumed.minimizers) {
+			minimums.insert(m);
+		}
+
+		upward_rounding rounding;
+		minimize_local(fun.f,resumed.tasks,resumed.threshold,min_ub,minimums,
+			       checkpoint_file,checkpoint_period);
+	} else if(rang == 0) {
 		// The information on the function chosen (pointer and initial box)
 		opt_fun_t fun;
 		
@@ -239,25 +296,65 @@ int main(int argc, char *argv[])
 		cin >> precision;
 		//precision = 0.007;
 
-  	minimize_mpi(fun.f,fun.x,fun.y,precision,min_ub,minimums);
+		// Interval operators require upward rounding during the whole search
+		upward_rounding rounding;
+		vector<task> local;
+  	minimize_mpi(fun.f,fun.x,fun.y,precision,min_ub,minimums,local);
+		minimize_local(fun.f,local,precision,min_ub,minimums,
+			       checkpoint_file,checkpoint_period);
 	} else {
 		itvfun f;
 		interval x, y;
 		MPI_Recv_Interval(f, x, y, precision, min_ub);
 
-		minimize(f, x, y, precision, min_ub,minimums);
+		upward_rounding rounding;
+		minimize_local(f,vector<task>{task{x,y}},precision,min_ub,minimums,
+			       checkpoint_file,checkpoint_period);
 	}
 
 	// Combining min_ub
 	double total_min_ub;
 	MPI_Reduce( &min_ub,&total_min_ub , 1, MPI_DOUBLE, MPI_MIN, 0,  MPI_COMM_WORLD);
-	
+
+	// Combining the lower bounds of the processors stopped by their
+	// budget: that of the boxes left unexplored and that of the
+	// minimizers
+	int stopped = budget.exhausted(), any_stopped;
+	MPI_Reduce(&stopped,&any_stopped,1,MPI_INT,MPI_LOR,0,MPI_COMM_WORLD);
+	minimums.sort();
+	double min_lb = budget.unexplored_bound(), total_min_lb;
+	if (minimums.begin() != minimums.end()) {
+		min_lb = min(min_lb,minimums.begin()->lbmin);
+	}
+	MPI_Reduce(&min_lb,&total_min_lb,1,MPI_DOUBLE,MPI_MIN,0,MPI_COMM_WORLD);
+
+	// Gathering the counters of all the processors on the first one
+	vector<search_stats> rank_stats(numprocs);
+	MPI_Gather(&local_stats,sizeof(search_stats),MPI_BYTE,
+		   rank_stats.data(),sizeof(search_stats),MPI_BYTE,0,MPI_COMM_WORLD);
+
 	if(rang == 0) {
 		// Displaying all potential minimizers
 		/*copy(minimums.begin(),minimums.end(),
 		     ostream_iterator<minimizer>(cout,"\n"));
 		cout << "Number of minimizers: " << minimums.size() << endl;*/
 		cout << "Upper bound for minimum: " << total_min_ub << endl;
+#if SEARCH_STATS
+		search_stats total;
+		for (const search_stats& s : rank_stats) {
+			total.add(s);
+		}
+		cout << "Number of boxes evaluated: " << total.evaluated << endl;
+		cout << "Number of boxes pruned: " << total.pruned << endl;
+#endif
+		if (any_stopped) {
+			// The minimum may lie in the boxes left unexplored as well
+			cout << "Search stopped by the budget" << endl;
+			cout << "Lower bound for minimum: " << total_min_lb << endl;
+		}
+		if (stats) {
+			write_stats(cout,rank_stats,"rank",stats_json);
+		}
 	}
 
 	MPI_Finalize();
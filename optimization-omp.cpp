@@ -12,87 +12,253 @@
 #include <iterator>
 #include <string>
 #include <stdexcept>
+#include <vector>
+#include <fstream>
+#include <sstream>
+#include <chrono>
+#include <cmath>
 #include "interval.h"
 #include "functions.h"
 #include "minimizer.h"
-#if _OPENMP
-#   include <omp.h>
-#endif
+#include "incumbent.h"
+#include "checkpoint.h"
+#include "budget.h"
+#include "work_stealing.h"
+#include "stats.h"
 
 using namespace std;
 
-// Split a 2D box into four subboxes by splitting each dimension
-// into two equal subparts
-void split_box(const interval& x, const interval& y,
-	       interval &xl, interval& xr, interval& yl, interval& yr)
+// Problem of a batch, with its result once solved
+struct job {
+  string function;
+  opt_fun_t fun; // Its domain may differ from the default one
+  double precision;
+
+  size_t minimizers;
+  double upper_bound;
+  double lower_bound; // Smallest lower bound of the minimizers
+  bool stopped; // By the budget
+  double seconds;
+};
+
+// Reading of a job file. Each line holds a function name and a
+// positive precision, optionally followed by the finite domain
+// "xl xr yl yr" (xl <= xr, yl <= yr) to use instead of the default one.
+// Empty lines and lines starting with '#' are ignored. The first line
+// that is not a job makes the whole file rejected.
+vector<job> read_jobs(const string& path)
+{
+  ifstream is(path);
+  if (!is) {
+    throw runtime_error("Cannot read " + path);
+  }
+  vector<job> jobs;
+  string line;
+  for (int n = 1; getline(is,line); ++n) {
+    istringstream fields(line);
+    job j;
+    if (!(fields >> j.function) || j.function[0] == '#') {
+      continue;
+    }
+    auto found = functions.find(j.function);
+    bool good = found != functions.end() && (fields >> j.precision)
+      && j.precision > 0 && isfinite(j.precision);
+    vector<double> domain;
+    for (double v; good && (fields >> v); ) {
+      domain.push_back(v);
+      good = isfinite(v);
+    }
+    // Nothing but numbers must follow the precision
+    good = good && fields.eof() && (domain.empty() || domain.size() == 4);
+    if (good && !domain.empty()) {
+      good = domain[0] <= domain[1] && domain[2] <= domain[3];
+    }
+    if (!good) {
+      throw runtime_error(path + ":" + to_string(n) + ": bad job");
+    }
+    j.fun = found->second;
+    if (!domain.empty()) {
+      j.fun.x = interval(domain[0],domain[1]);
+      j.fun.y = interval(domain[2],domain[3]);
+    }
+    jobs.push_back(j);
+  }
+  return jobs;
+}
+
+// Solving of j by nthreads threads
+void solve(job& j, int nthreads, double time_limit,
+	   unsigned long long max_evaluations)
 {
-  double xm = x.mid();
-  double ym = y.mid();
-  xl = interval(x.left(),xm);
-  xr = interval(xm,x.right());
-  yl = interval(y.left(),ym);
-  yr = interval(ym,y.right());
+  auto start = chrono::steady_clock::now();
+  upward_rounding rounding;
+  shared_incumbent min_ub;
+  minimizer_list ml;
+  search_budget budget;
+  if (time_limit > 0) {
+    budget.limit_time(time_limit);
+  }
+  if (max_evaluations > 0) {
+    budget.limit_evaluations(max_evaluations);
+  }
+  work_stealing_search search(j.fun.f,j.precision,min_ub,ml,nthreads);
+  search.limit(budget);
+  search.run(j.fun.x,j.fun.y);
+
+  ml.sort();
+  j.minimizers = ml.size();
+  j.upper_bound = min_ub.load();
+  j.lower_bound = budget.unexplored_bound();
+  if (ml.begin() != ml.end()) {
+    j.lower_bound = min(j.lower_bound,ml.begin()->lbmin);
+  }
+  j.stopped = budget.exhausted();
+  j.seconds = chrono::duration<double>(chrono::steady_clock::now()-start).count();
+}
+
+// Number in JSON, where infinities are not allowed
+string json_number(double v)
+{
+  if (!isfinite(v)) {
+    return "null";
+  }
+  ostringstream os;
+  os.precision(16);
+  os << v;
+  return os.str();
 }
 
-// Branch-and-bound minimization algorithm
-void minimize(itvfun f,  // Function to minimize
-	      const interval& x, // Current bounds for 1st dimension
-	      const interval& y, // Current bounds for 2nd dimension
-	      double threshold,  // Threshold at which we should stop splitting
-	      double& min_ub,  // Current minimum upper bound
-	      minimizer_list& ml) // List of current minimizers
+// Solving of all the jobs, either one after the other by all the
+// threads or at the same time, one job per thread. The results are
+// written in order as JSON lines, followed by a summary line.
+void run_batch(vector<job>& jobs, bool concurrent, double time_limit,
+	       unsigned long long max_evaluations)
 {
-  interval fxy = f(x,y);
-     
-  if (fxy.left() > min_ub) { // Current box cannot contain minimum?
-    return ;
-  }
-
-  if (fxy.right() < min_ub) { // Current box contains a new minimum?
-    min_ub = fxy.right();
-    // Discarding all saved boxes whose minimum lower bound is 
-    // greater than the new minimum upper bound
-    auto discard_begin = ml.lower_bound(minimizer{0,0,min_ub,0});
-	
-		#pragma  omp critical 
-		ml.erase(discard_begin,ml.end());
-  }
-
-  // Checking whether the input box is small enough to stop searching.
-  // We can consider the width of one dimension only since a box
-  // is always split equally along both dimensions
-  if (x.width() <= threshold) { 
-    // We have potentially a new minimizer
-	 	#pragma  omp critical 
-    ml.insert(minimizer{x,y,fxy.left(),fxy.right()});
-    
-    return ;
-  }
-
-  // The box is still large enough => we split it into 4 sub-boxes
-  // and recursively explore them
-  interval xl, xr, yl, yr;
-  split_box(x,y,xl,xr,yl,yr);
-
-  #pragma omp parallel  
-	#pragma omp sections
-	{
-		#pragma omp section
-		minimize(f,xl,yl,threshold,min_ub,ml);
-		#pragma omp section
-		minimize(f,xl,yr,threshold,min_ub,ml);
-		#pragma omp section
-		minimize(f,xr,yl,threshold,min_ub,ml);
-		#pragma omp section
-		minimize(f,xr,yr,threshold,min_ub,ml);
+  auto start = chrono::steady_clock::now();
+  if (concurrent) {
+    #pragma omp parallel for schedule(dynamic,1)
+    for (size_t i = 0; i < jobs.size(); ++i) {
+      solve(jobs[i],1,time_limit,max_evaluations);
+    }
+  } else {
+    for (job& j : jobs) {
+      solve(j,omp_get_max_threads(),time_limit,max_evaluations);
+    }
   }
+  double seconds =
+    chrono::duration<double>(chrono::steady_clock::now()-start).count();
+
+  for (size_t i = 0; i < jobs.size(); ++i) {
+    const job& j = jobs[i];
+    cout << "{\"job\": " << i
+	 << ", \"function\": \"" << j.function << "\""
+	 << ", \"domain\": [[" << json_number(j.fun.x.left()) << ", "
+	 << json_number(j.fun.x.right()) << "], ["
+	 << json_number(j.fun.y.left()) << ", "
+	 << json_number(j.fun.y.right()) << "]]"
+	 << ", \"precision\": " << json_number(j.precision)
+	 << ", \"minimizers\": " << j.minimizers
+	 << ", \"upper_bound\": " << json_number(j.upper_bound)
+	 << ", \"lower_bound\": " << json_number(j.lower_bound)
+	 << ", \"stopped\": " << (j.stopped ? "true" : "false")
+	 << ", \"seconds\": " << json_number(j.seconds) << "}" << endl;
+  }
+  cout << "{\"jobs\": " << jobs.size()
+       << ", \"mode\": \"" << (concurrent ? "concurrent" : "sequential") << "\""
+       << ", \"threads\": " << omp_get_max_threads()
+       << ", \"seconds\": " << json_number(seconds)
+       << ", \"jobs_per_second\": " << json_number(jobs.size()/seconds) << "}"
+       << endl;
 }
 
-int main(void)
+// Usage: optimization-omp [--cluster] [--checkpoint=FILE]
+//                         [--checkpoint-period=SECONDS] [--resume=FILE]
+//                         [--time-limit=SECONDS] [--max-evaluations=N]
+//                         [--trace-incumbent] [--stats[=json]]
+//                         [--batch=FILE [--concurrent]]
+//   --cluster: display the clusters of touching minimizers (see
+//              cluster_minimizers)
+//   --checkpoint: write a checkpoint of the search to FILE every
+//                 SECONDS seconds (default: 60)
+//   --resume: resume the search from the checkpoint FILE instead of
+//             asking for a function and a precision
+//   --time-limit, --max-evaluations: stop exploring boxes after
+//             SECONDS seconds or N evaluations of the function (see
+//             search_budget)
+//   --trace-incumbent: write each new upper bound to the standard
+//             error as soon as it is found
+//   --stats: display the counters of each thread and their sum (see
+//            search_stats), as text or as JSON. They are not available
+//            if the program was compiled with SEARCH_STATS=0
+//   --batch: solve the jobs of FILE (see read_jobs) instead of asking
+//            for a function and a precision, and write the results as
+//            JSON lines. The jobs are solved one after the other by
+//            all the threads, or at the same time, one per thread,
+//            with --concurrent (see run_batch). The budget applies to
+//            each job.
+int main(int argc, char *argv[])
 {
   cout.precision(16);
+  bool cluster = false;
+  string checkpoint_file, resume_file;
+  double checkpoint_period = 60;
+  double time_limit = 0;
+  unsigned long long max_evaluations = 0;
+  bool trace = false;
+  bool stats = false, stats_json = false;
+  string batch_file;
+  bool concurrent = false;
+  for (int i = 1; i < argc; ++i) {
+    string option(argv[i]);
+    if (option == "--cluster") {
+      cluster = true;
+    } else if (option.compare(0,13,"--checkpoint=") == 0) {
+      checkpoint_file = option.substr(13);
+    } else if (option.compare(0,20,"--checkpoint-period=") == 0) {
+      checkpoint_period = stod(option.substr(20));
+    } else if (option.compare(0,9,"--resume=") == 0) {
+      resume_file = option.substr(9);
+    } else if (option.compare(0,13,"--time-limit=") == 0) {
+      time_limit = stod(option.substr(13));
+    } else if (option.compare(0,18,"--max-evaluations=") == 0) {
+      max_evaluations = stoull(option.substr(18));
+    } else if (option == "--trace-incumbent") {
+      trace = true;
+    } else if (option == "--stats" || option == "--stats=json") {
+      stats = true;
+      stats_json = (option == "--stats=json");
+    } else if (option.compare(0,8,"--batch=") == 0) {
+      batch_file = option.substr(8);
+    } else if (option == "--concurrent") {
+      concurrent = true;
+    } else {
+      cerr << "Unknown option: " << argv[i] << endl;
+      return 1;
+    }
+  }
+
+  if (!batch_file.empty()) {
+    if (cluster || trace || stats || !checkpoint_file.empty()
+	|| !resume_file.empty()) {
+      cerr << "Only the budget and --concurrent apply to --batch" << endl;
+      return 1;
+    }
+    try {
+      vector<job> jobs = read_jobs(batch_file);
+      run_batch(jobs,concurrent,time_limit,max_evaluations);
+    } catch (exception& e) {
+      cerr << e.what() << endl;
+      return 1;
+    }
+    return 0;
+  }
+
   // By default, the currently known upper bound for the minimizer is +oo
-  double min_ub = numeric_limits<double>::infinity();
+  shared_incumbent min_ub;
+  if (trace) {
+    min_ub.listen(trace_incumbent(cerr));
+  }
+  search_budget budget;
   // List of potential minimizers. They may be removed from the list
   // if we later discover that their smallest minimum possible is 
   // greater than the new current upper bound
@@ -106,9 +272,33 @@ int main(void)
   // The information on the function chosen (pointer and initial box)
   opt_fun_t fun;
   
-  bool good_choice;
+  // The search to resume, if any
+  checkpoint resumed;
+  if (!resume_file.empty()) {
+    try {
+      resumed = read_checkpoint(resume_file);
+      // The checkpoint of one processor of optimization-mpi only holds
+      // its part of the search
+      if (resumed.parts != 1) {
+	throw runtime_error("The checkpoint was written by "
+			    + to_string(resumed.parts) + " processors");
+      }
+      fun = functions.at(resumed.function);
+    } catch (exception& e) {
+      cerr << e.what() << endl;
+      return 1;
+    }
+    choice_fun = resumed.function;
+    precision = resumed.threshold;
+    min_ub.lower(resumed.min_ub);
+    for (const minimizer& m : resumed.minimizers) {
+      minimums.insert(m);
+    }
+  }
+
+  bool good_choice = !resume_file.empty();
   // Asking the user for the name of the function to optimize
-  do {
+  while (!good_choice) {
     good_choice = true;
 
     cout << "Which function to optimize?\n";
@@ -126,17 +316,76 @@ int main(void)
       cerr << "Bad choice" << endl;
       good_choice = false;
     }
-  } while(!good_choice);
+  }
+
+  if (stats && !SEARCH_STATS) {
+    cerr << "No statistics: compiled with SEARCH_STATS=0" << endl;
+    stats = false;
+  }
 
-  // Asking for the threshold below which a box is not split further
-  cout << "Precision? ";
-  cin >> precision;
-  //precision = 0.007;
-  minimize(fun.f,fun.x,fun.y,precision,min_ub,minimums);
+  if (resume_file.empty()) {
+    // Asking for the threshold below which a box is not split further
+    cout << "Precision? ";
+    cin >> precision;
+    //precision = 0.007;
+  }
+  // Counters of each thread
+  vector<search_stats> thread_stats;
+  {
+    // Interval operators require upward rounding during the whole search
+    upward_rounding rounding;
+    work_stealing_search search(fun.f,precision,min_ub,minimums,
+				omp_get_max_threads());
+    if (!checkpoint_file.empty()) {
+      search.checkpoint_to(checkpoint_file,checkpoint_period,choice_fun);
+    }
+    if (time_limit > 0) {
+      budget.limit_time(time_limit);
+    }
+    if (max_evaluations > 0) {
+      budget.limit_evaluations(max_evaluations);
+    }
+    search.limit(budget);
+    if (resume_file.empty()) {
+      search.run(fun.x,fun.y);
+    } else {
+      search.run(resumed.tasks);
+    }
+    for (int i = 0; i < search.threads(); ++i) {
+      thread_stats.push_back(search.thread_stats(i));
+    }
+  }
   
   // Displaying all potential minimizers
+  minimums.sort();
   /*copy(minimums.begin(),minimums.end(),
        ostream_iterator<minimizer>(cout,"\n"));   */ 
   cout << "Number of minimizers: " << minimums.size() << endl;
-  cout << "Upper bound for minimum: " << min_ub << endl;
+  cout << "Upper bound for minimum: " << min_ub.load() << endl;
+#if SEARCH_STATS
+  search_stats total;
+  for (const search_stats& s : thread_stats) {
+    total.add(s);
+  }
+  cout << "Number of boxes evaluated: " << total.evaluated << endl;
+  cout << "Number of boxes pruned: " << total.pruned << endl;
+#endif
+  if (budget.exhausted()) {
+    // The minimum may lie in the boxes left unexplored as well
+    double lb = budget.unexplored_bound();
+    if (minimums.begin() != minimums.end()) {
+      lb = min(lb,minimums.begin()->lbmin);
+    }
+    cout << "Search stopped by the budget" << endl;
+    cout << "Lower bound for minimum: " << lb << endl;
+  }
+  if (cluster) {
+    vector<minimizer> clusters = cluster_minimizers(minimums);
+    cout << "Number of clusters: " << clusters.size() << endl;
+    copy(clusters.begin(),clusters.end(),
+	 ostream_iterator<minimizer>(cout,"\n"));
+  }
+  if (stats) {
+    write_stats(cout,thread_stats,"thread",stats_json);
+  }
 }
@@ -12,72 +12,687 @@
 #include <iterator>
 #include <string>
 #include <stdexcept>
+#include <algorithm>
+#include <vector>
 #include "interval.h"
 #include "functions.h"
 #include "minimizer.h"
+#include "spill.h"
+#include "incumbent.h"
+#include "budget.h"
 
 using namespace std;
 
+// Number of boxes over which the function has been evaluated
+unsigned long long evaluated_boxes = 0;
+// Number of boxes discarded because the function is certainly greater
+// than the current upper bound over them
+unsigned long long pruned_boxes = 0;
+// Number of evaluations of the function at a point
+unsigned long long evaluated_points = 0;
 
-// Split a 2D box into four subboxes by splitting each dimension
-// into two equal subparts
-void split_box(const interval& x, const interval& y,
-	       interval &xl, interval& xr, interval& yl, interval& yr)
+// Should the upper bound also be lowered with the values of the
+// function at the centers of the boxes split and by local descents?
+bool point_search = true;
+// Initial box, to which the points of the local descents are confined
+interval domain_x, domain_y;
+// Largest number of steps of a local descent
+const int descent_steps = 40;
+
+// Budget of the search. The boxes left once it is exhausted are not
+// explored
+search_budget budget;
+// Told of each new upper bound, if set
+incumbent_listener on_new_upper_bound;
+
+// Strategies to split a box:
+// - split_four: each dimension is cut in two equal parts (four
+//   sub-boxes);
+// - split_widest: the widest dimension only is cut in two;
+// - split_smear: the dimension along which the width times the
+//   magnitude of the partial derivative (i.e., the possible variation
+//   of f) is the largest is cut in two.
+// In all cases, a dimension no wider than the threshold is not cut.
+enum split_strategy { split_four, split_widest, split_smear };
+split_strategy strategy = split_four;
+
+// Magnitude of the interval I
+inline double mag(const interval& I)
 {
-  double xm = x.mid();
-  double ym = y.mid();
-  xl = interval(x.left(),xm);
-  xr = interval(xm,x.right());
-  yl = interval(y.left(),ym);
-  yr = interval(ym,y.right());
+  return max(-I.left(),I.right());
 }
 
-// Branch-and-bound minimization algorithm
+// Split the 2D box x*y into two or four sub-boxes xs[i]*ys[i]
+// according to the current strategy. Returns the number of sub-boxes.
+// The gradient g of f over x*y, if available, is used by the Smear
+// strategy; otherwise, it is computed with gf.
+int split_box(const interval& x, const interval& y, double threshold,
+	      gradfun gf, const gradient* g, interval xs[4], interval ys[4])
+{
+  bool cut_x = x.width() > threshold;
+  bool cut_y = y.width() > threshold;
+  if (cut_x && cut_y && strategy != split_four) {
+    if (strategy == split_widest) {
+      cut_x = x.width() >= y.width();
+    } else {
+      gradient gxy = g ? *g : gf(gradient::x(x),gradient::y(y));
+      evaluated_boxes += !g;
+      cut_x = mag(gxy.dx)*x.width() >= mag(gxy.dy)*y.width();
+    }
+    cut_y = !cut_x;
+  }
+
+  interval xh[2] = {x, x};
+  interval yh[2] = {y, y};
+  if (cut_x) {
+    double xm = x.mid();
+    xh[0] = interval(x.left(),xm);
+    xh[1] = interval(xm,x.right());
+  }
+  if (cut_y) {
+    double ym = y.mid();
+    yh[0] = interval(y.left(),ym);
+    yh[1] = interval(ym,y.right());
+  }
+  int n = 0;
+  for (int i = 0; i <= cut_x; ++i) {
+    for (int j = 0; j <= cut_y; ++j) {
+      xs[n] = xh[i];
+      ys[n] = yh[j];
+      ++n;
+    }
+  }
+  return n;
+}
+
+// Is the budget of the search exhausted? The evaluations counted so
+// far are charged to it by batches (see budget_meter)
+bool out_of_budget(void)
+{
+  static unsigned long long charged = 0;
+  unsigned long long spent = evaluated_boxes+evaluated_points;
+  if (spent-charged >= budget_meter::batch) {
+    budget.charge(spent-charged);
+    charged = spent;
+  }
+  return budget.exhausted();
+}
+
+// Checking whether the box x*y is small enough to stop searching
+inline bool small_enough(const interval& x, const interval& y,
+			 double threshold)
+{
+  return x.width() <= threshold && y.width() <= threshold;
+}
+
+// Lowering of the current minimum upper bound to ub, an upper bound
+// of f over some box or at some point, if it is smaller. List is
+// minimizer_list or minimizer_list_n<N>.
+template<typename List>
+void update_upper_bound(double ub, double& min_ub, List& ml)
+{
+  if (ub < min_ub) { // Current box contains a new minimum?
+    min_ub = ub;
+    // Discarding all saved boxes whose minimum lower bound is 
+    // greater than the new minimum upper bound
+    ml.discard_above(min_ub);
+    if (on_new_upper_bound) {
+      on_new_upper_bound(min_ub);
+    }
+  }
+}
+
+// Local descent by compass search from the point (px, py), at which f
+// is at most fp: the four points at distance step of the current one
+// along the axes are evaluated at once; the best one replaces the
+// current point if it is better, and the step is doubled; otherwise,
+// the step is halved. Returns an upper bound of f at the final point.
+double local_descent(itvfun f, double px, double py, double fp,
+		     double step)
+{
+  for (int k = 0; k < descent_steps; ++k) {
+    double qx[4] = {px-step, px+step, px, px};
+    double qy[4] = {py, py, py-step, py+step};
+    for (int i = 0; i < 4; ++i) {
+      qx[i] = min(max(qx[i],domain_x.left()),domain_x.right());
+      qy[i] = min(max(qy[i],domain_y.left()),domain_y.right());
+    }
+    double fr[4];
+    for (int i = 0; i < 4; ++i) {
+      fr[i] = f(qx[i],qy[i]).right();
+    }
+    evaluated_points += 4;
+
+    int best = min_element(fr,fr+4)-fr;
+    if (fr[best] < fp) {
+      px = qx[best];
+      py = qy[best];
+      fp = fr[best];
+      step *= 2;
+    } else {
+      step /= 2;
+    }
+  }
+  return fp;
+}
+
+// Lowering of the current minimum upper bound with the upper bound fp
+// of f at the point (px, py). A point better than all the boxes and
+// points seen so far is the start of a local descent.
+void improve_upper_bound(itvfun f, double px, double py, double fp,
+			 double step, double& min_ub, minimizer_list& ml)
+{
+  if (fp < min_ub) {
+    fp = local_descent(f,px,py,fp,step);
+  }
+  update_upper_bound(fp,min_ub,ml);
+}
+
+// Branch-and-bound minimization algorithm on a box whose image by the
+// function has already been computed
 void minimize(itvfun f,  // Function to minimize
+	      gradfun gf, // Its gradient (for the Smear strategy)
 	      const interval& x, // Current bounds for 1st dimension
 	      const interval& y, // Current bounds for 2nd dimension
+	      const interval& fxy, // Enclosure of f over the current box
 	      double threshold,  // Threshold at which we should stop splitting
 	      double& min_ub,  // Current minimum upper bound
 	      minimizer_list& ml) // List of current minimizers
 {
-  interval fxy = f(x,y);
-  
   if (fxy.left() > min_ub) { // Current box cannot contain minimum?
+    ++pruned_boxes;
     return ;
   }
 
-  if (fxy.right() < min_ub) { // Current box contains a new minimum?
-    min_ub = fxy.right();
-    // Discarding all saved boxes whose minimum lower bound is 
-    // greater than the new minimum upper bound
-    auto discard_begin = ml.lower_bound(minimizer{0,0,min_ub,0});
-    ml.erase(discard_begin,ml.end());
+  update_upper_bound(fxy.right(),min_ub,ml);
+
+  if (small_enough(x,y,threshold)) { 
+    // We have potentially a new minimizer
+    ml.insert(minimizer{x,y,fxy.left(),fxy.right()});
+    return ;
+  }
+
+  if (out_of_budget()) { // The box is left unexplored
+    budget.skip(fxy.left());
+    return ;
+  }
+
+  // The box is still large enough => we split it into sub-boxes,
+  // evaluate the function over all of them and recursively explore them
+  interval xs[4], ys[4];
+  int n = split_box(x,y,threshold,gf,nullptr,xs,ys);
+
+  interval fs[4];
+  for (int i = 0; i < n; ++i) {
+    fs[i] = f(xs[i],ys[i]);
+  }
+  evaluated_boxes += n;
+  if (point_search) { // The center of the box is evaluated as well
+    double cx = x.mid();
+    double cy = y.mid();
+    ++evaluated_points;
+    improve_upper_bound(f,cx,cy,f(cx,cy).right(),max(x.width(),y.width())/4,
+			min_ub,ml);
+  }
+
+  for (int i = 0; i < n; ++i) {
+    minimize(f,gf,xs[i],ys[i],fs[i],threshold,min_ub,ml);
+  }
+}
+
+// Branch-and-bound minimization algorithm
+void minimize(itvfun f,  // Function to minimize
+	      gradfun gf, // Its gradient (for the Smear strategy)
+	      const interval& x, // Initial bounds for 1st dimension
+	      const interval& y, // Initial bounds for 2nd dimension
+	      double threshold,  // Threshold at which we should stop splitting
+	      double& min_ub,  // Current minimum upper bound
+	      minimizer_list& ml) // List of current minimizers
+{
+  interval fxy = f(x,y);
+  ++evaluated_boxes;
+  minimize(f,gf,x,y,fxy,threshold,min_ub,ml);
+}
+
+// Box waiting to be explored by the best-first search
+struct pending_box {
+  interval x;
+  interval y;
+  interval fxy; // Enclosure of f over x*y
+};
+
+// Ordering of the priority queue of the best-first search: the box
+// with the smallest lower bound for f is on top
+struct greater_lower_bound {
+  bool operator()(const pending_box& b1, const pending_box& b2) const
+  {
+    return b1.fxy.left() > b2.fxy.left();
   }
+};
+
+// Best-first branch-and-bound minimization algorithm. The pending
+// boxes are kept in a priority queue and the one with the smallest
+// lower bound is always split first, so that the boxes that cannot
+// contain the minimum are never split. Once max_pending boxes are
+// waiting, the box on top of the queue is explored depth-first by the
+// recursive algorithm instead, so that the queue stops growing.
+//
+// If max_resident is not 0, the queue holds at most max_resident boxes
+// in memory: when it is full, its worst half is spilled to disk (see
+// spill_store). The spilled boxes are read back whenever the best of
+// them has a smaller lower bound than the top of the queue, so that the
+// boxes are still split by increasing lower bound.
+void minimize_best_first(itvfun f,  // Function to minimize
+			 gradfun gf, // Its gradient (for the Smear strategy)
+			 const interval& x, // Initial bounds for 1st dimension
+			 const interval& y, // Initial bounds for 2nd dimension
+			 double threshold,  // Threshold at which we should stop splitting
+			 double& min_ub,  // Current minimum upper bound
+			 minimizer_list& ml, // List of current minimizers
+			 size_t max_pending, // Largest size of the queue
+			 size_t max_resident) // Largest size in memory (0: no limit)
+{
+  // Heap ordered by greater_lower_bound, so that the worst boxes can be
+  // moved out of it
+  vector<pending_box> pending;
+  spill_store<pending_box,greater_lower_bound> spilled;
+  greater_lower_bound after;
+
+  pending.push_back(pending_box{x,y,f(x,y)});
+  ++evaluated_boxes;
+
+  while (!pending.empty() || !spilled.empty()) {
+    if (!spilled.empty()
+	&& (pending.empty() || after(pending.front(),spilled.top()))) {
+      // Reading back the best spilled boxes until half the queue is used
+      do {
+	pending.push_back(spilled.take());
+	push_heap(pending.begin(),pending.end(),after);
+      } while (!spilled.empty() && pending.size() < max_resident/2
+	       && after(pending.front(),spilled.top()));
+    }
+
+    pop_heap(pending.begin(),pending.end(),after);
+    pending_box b = pending.back();
+    pending.pop_back();
+
+    if (b.fxy.left() > min_ub) {
+      // No remaining box can contain the minimum either
+      pruned_boxes += pending.size()+spilled.size()+1;
+      break;
+    }
+
+    if (pending.size() >= max_pending) { // Depth-first dive
+      minimize(f,gf,b.x,b.y,b.fxy,threshold,min_ub,ml);
+      continue;
+    }
+
+    update_upper_bound(b.fxy.right(),min_ub,ml);
+
+    if (small_enough(b.x,b.y,threshold)) {
+      // We have potentially a new minimizer
+      ml.insert(minimizer{b.x,b.y,b.fxy.left(),b.fxy.right()});
+      continue;
+    }
+
+    if (out_of_budget()) {
+      // The boxes left, whose lower bounds are not smaller, are not
+      // explored either
+      budget.skip(b.fxy.left());
+      break;
+    }
 
-  // Checking whether the input box is small enough to stop searching.
-  // We can consider the width of one dimension only since a box
-  // is always split equally along both dimensions
-  if (x.width() <= threshold) { 
+    interval xs[4], ys[4];
+    int n = split_box(b.x,b.y,threshold,gf,nullptr,xs,ys);
+
+    interval fs[4];
+    for (int i = 0; i < n; ++i) {
+      fs[i] = f(xs[i],ys[i]);
+    }
+    evaluated_boxes += n;
+    if (point_search) { // The center of the box is evaluated as well
+      double cx = b.x.mid();
+      double cy = b.y.mid();
+      ++evaluated_points;
+      improve_upper_bound(f,cx,cy,f(cx,cy).right(),
+			  max(b.x.width(),b.y.width())/4,min_ub,ml);
+    }
+
+    // The upper bounds of the subboxes are taken into account at once
+    // to prune their siblings
+    for (int i = 0; i < n; ++i) {
+      update_upper_bound(fs[i].right(),min_ub,ml);
+    }
+    for (int i = 0; i < n; ++i) {
+      if (fs[i].left() > min_ub) {
+	++pruned_boxes;
+      } else {
+	pending.push_back(pending_box{xs[i],ys[i],fs[i]});
+	push_heap(pending.begin(),pending.end(),after);
+      }
+    }
+
+    if (max_resident != 0 && pending.size() >= max_resident) {
+      // Spilling the boxes with the largest lower bounds
+      auto middle = pending.begin()+pending.size()/2;
+      nth_element(pending.begin(),middle,pending.end(),
+		  [&after](const pending_box& b1, const pending_box& b2) {
+		    return after(b2,b1);
+		  });
+      vector<pending_box> worst(middle,pending.end());
+      pending.erase(middle,pending.end());
+      make_heap(pending.begin(),pending.end(),after);
+      spilled.spill(worst);
+    }
+  }
+}
+
+// Is f monotonic over the box x*y along one variable, in a direction
+// such that its minimum over the box is reached on a face of the box
+// that is also a face of a neighboring box (i.e., not on the boundary
+// of the initial domain)? In that case, the box cannot contain a
+// global minimizer that is not also in the neighboring box.
+bool monotonic_inside(const opt_fun_t& fun,
+		      const interval& x, const interval& y, const gradient& g)
+{
+  return (g.dx.left() > 0 && x.left() > fun.x.left())
+    || (g.dx.right() < 0 && x.right() < fun.x.right())
+    || (g.dy.left() > 0 && y.left() > fun.y.left())
+    || (g.dy.right() < 0 && y.right() < fun.y.right());
+}
+
+// Branch-and-bound minimization algorithm using the gradient of the
+// function to discard boxes on which it is monotonic and to tighten
+// its enclosure with the mean value form
+void minimize_gradient(const opt_fun_t& fun, // Function to minimize
+		       const interval& x, // Current bounds for 1st dimension
+		       const interval& y, // Current bounds for 2nd dimension
+		       double threshold,  // Threshold at which we should stop splitting
+		       double& min_ub,  // Current minimum upper bound
+		       minimizer_list& ml) // List of current minimizers
+{
+  gradient g = fun.g(gradient::x(x),gradient::y(y));
+  ++evaluated_boxes;
+
+  if (monotonic_inside(fun,x,y,g)) {
+    return ;
+  }
+
+  // Mean value form: f(x,y) is in f(c) + g_x*(x-cx) + g_y*(y-cy)
+  // for c = (cx, cy) the center of the box
+  double cx = x.mid();
+  double cy = y.mid();
+  interval fc = fun.f(cx,cy);
+  interval mvf = fc + g.dx*(x-cx) + g.dy*(y-cy);
+  interval fxy(max(g.value.left(),mvf.left()),
+	       min(g.value.right(),mvf.right()));
+  if (point_search) {
+    ++evaluated_points;
+    improve_upper_bound(fun.f,cx,cy,fc.right(),max(x.width(),y.width())/4,
+			min_ub,ml);
+  }
+
+  if (fxy.left() > min_ub) { // Current box cannot contain minimum?
+    ++pruned_boxes;
+    return ;
+  }
+
+  update_upper_bound(fxy.right(),min_ub,ml);
+
+  if (small_enough(x,y,threshold)) { 
     // We have potentially a new minimizer
     ml.insert(minimizer{x,y,fxy.left(),fxy.right()});
     return ;
   }
 
-  // The box is still large enough => we split it into 4 sub-boxes
+  if (out_of_budget()) { // The box is left unexplored
+    budget.skip(fxy.left());
+    return ;
+  }
+
+  // The box is still large enough => we split it into sub-boxes
   // and recursively explore them
-  interval xl, xr, yl, yr;
-  split_box(x,y,xl,xr,yl,yr);
+  interval xs[4], ys[4];
+  int n = split_box(x,y,threshold,fun.g,&g,xs,ys);
+  for (int i = 0; i < n; ++i) {
+    minimize_gradient(fun,xs[i],ys[i],threshold,min_ub,ml);
+  }
+}
+
+// Local descent by compass search for a function of N variables (see
+// local_descent): the 2N points at distance step of the current point
+// p along the axes are tried in turn
+template<unsigned int N>
+double local_descent_n(const opt_fun_n_t<N>& fun, box<N> p, double fp,
+		       double step)
+{
+  for (int k = 0; k < descent_steps; ++k) {
+    box<N> best = p;
+    double fbest = fp;
+    for (unsigned int i = 0; i < N; ++i) {
+      for (double d : {-step, step}) {
+	box<N> q = p;
+	double qi = min(max(p[i].left()+d,fun.domain[i].left()),
+			fun.domain[i].right());
+	q[i] = interval(qi);
+	double fq = fun.f(q).right();
+	++evaluated_points;
+	if (fq < fbest) {
+	  best = q;
+	  fbest = fq;
+	}
+      }
+    }
+    if (fbest < fp) {
+      p = best;
+      fp = fbest;
+      step *= 2;
+    } else {
+      step /= 2;
+    }
+  }
+  return fp;
+}
+
+// Branch-and-bound minimization algorithm for a function of N
+// variables on a box whose image by the function has already been
+// computed. Boxes are bisected along their widest dimension, so that
+// the number of sub-boxes does not grow with N.
+template<unsigned int N>
+void minimize_n(const opt_fun_n_t<N>& fun,  // Function to minimize
+		const box<N>& b, // Current box
+		const interval& fb, // Enclosure of f over the current box
+		double threshold,  // Threshold at which we should stop splitting
+		double& min_ub,  // Current minimum upper bound
+		minimizer_list_n<N>& ml) // List of current minimizers
+{
+  if (fb.left() > min_ub) { // Current box cannot contain minimum?
+    ++pruned_boxes;
+    return ;
+  }
+
+  update_upper_bound(fb.right(),min_ub,ml);
 
-  minimize(f,xl,yl,threshold,min_ub,ml);
-  minimize(f,xl,yr,threshold,min_ub,ml);
-  minimize(f,xr,yl,threshold,min_ub,ml);
-  minimize(f,xr,yr,threshold,min_ub,ml);
+  if (b.width() <= threshold) {
+    // We have potentially a new minimizer
+    ml.insert(minimizer_n<N>{b,fb.left(),fb.right()});
+    return ;
+  }
+
+  if (out_of_budget()) { // The box is left unexplored
+    budget.skip(fb.left());
+    return ;
+  }
+
+  if (point_search) {
+    box<N> c = b.center();
+    double fc = fun.f(c).right();
+    ++evaluated_points;
+    if (fc < min_ub) {
+      fc = local_descent_n(fun,c,fc,b.width()/4);
+    }
+    update_upper_bound(fc,min_ub,ml);
+  }
+
+  box<N> l, r;
+  bisect(b,b.widest(),l,r);
+  interval fl = fun.f(l);
+  interval fr = fun.f(r);
+  evaluated_boxes += 2;
+
+  minimize_n(fun,l,fl,threshold,min_ub,ml);
+  minimize_n(fun,r,fr,threshold,min_ub,ml);
+}
+
+// Minimization of the function name of dim variables. The dimension
+// chosen at run time selects the instance of minimize_n to use.
+// Returns the number of minimizers found, the smallest lower bound of
+// which is saved in min_lb.
+template<unsigned int N>
+size_t minimize_dimension(unsigned int dim, const string& name,
+			  double threshold, double& min_ub, double& min_lb)
+{
+  if (dim != N) {
+    return minimize_dimension<N+1>(dim,name,threshold,min_ub,min_lb);
+  }
+  const opt_fun_n_t<N>& fun = functions_n<N>().at(name);
+  minimizer_list_n<N> ml;
+  interval fb = fun.f(fun.domain);
+  ++evaluated_boxes;
+  minimize_n(fun,fun.domain,fb,threshold,min_ub,ml);
+  ml.sort();
+  if (ml.begin() != ml.end()) {
+    min_lb = ml.begin()->lbmin;
+  }
+  return ml.size();
+}
+
+template<>
+size_t minimize_dimension<max_dimension+1>(unsigned int dim, const string& name,
+					   double threshold, double& min_ub,
+					   double& min_lb)
+{
+  return 0;
+}
+
+// Splitting of a choice such as "rosenbrock-4" into the name of a
+// function of N variables and N. Returns 0 if the choice is not the
+// name of such a function followed by a valid dimension.
+unsigned int parse_dimension(const string& choice, string& name)
+{
+  size_t dash = choice.rfind('-');
+  if (dash == string::npos) {
+    return 0;
+  }
+  name = choice.substr(0,dash);
+  unsigned int dim = atoi(choice.c_str()+dash+1);
+  if (dim < min_dimension || dim > max_dimension
+      || functions_n<min_dimension>().count(name) == 0) {
+    return 0;
+  }
+  return dim;
 }
 
 
-int main(void)
+// Usage: optimization-seq [--gradient | --affine] [--best-first[=N]]
+//                         [--no-descent] [--split=four|widest|smear]
+//                         [--cluster] [--memory=MB]
+//                         [--time-limit=SECONDS] [--max-evaluations=N]
+//                         [--trace-incumbent]
+//   --gradient: use the gradient of the function to discard and
+//               bound boxes (see minimize_gradient)
+//   --affine: bound the function in affine arithmetic instead of
+//             interval arithmetic
+//   --best-first: explore the boxes by increasing lower bound
+//                 (see minimize_best_first), diving depth-first once
+//                 N boxes are pending (default: 1048576)
+//   --no-descent: lower the upper bound with the enclosures of f over
+//                 boxes only, without evaluating it at their centers
+//                 and running local descents (see improve_upper_bound)
+//   --split: strategy to split the boxes (see split_strategy;
+//            default: four)
+//   --memory: explore the boxes best-first without ever diving,
+//             spilling pending boxes to disk to keep about MB (>= 1)
+//             megabytes of them in memory (see minimize_best_first).
+//             It cannot be given with --best-first=N
+//   --cluster: display the clusters of touching minimizers (see
+//              cluster_minimizers)
+//   --time-limit, --max-evaluations: stop exploring boxes after
+//             SECONDS seconds or N evaluations of the function (see
+//             search_budget)
+//   --trace-incumbent: write each new upper bound to the standard
+//             error as soon as it is found
+// Only --no-descent, the budget and --trace-incumbent apply to the
+// functions of more than two variables (see minimize_n).
+int main(int argc, char *argv[])
 {
   cout.precision(16);
+  bool use_gradient = false;
+  bool use_affine = false;
+  bool best_first = false;
+  size_t max_pending = 1 << 20;
+  bool dive = false; // --best-first=N given
+  size_t max_resident = 0;
+  bool cluster = false;
+  double time_limit = 0;
+  unsigned long long max_evaluations = 0;
+  for (int i = 1; i < argc; ++i) {
+    string option(argv[i]);
+    if (option == "--gradient") {
+      use_gradient = true;
+    } else if (option == "--affine") {
+      use_affine = true;
+    } else if (option == "--split=four") {
+      strategy = split_four;
+    } else if (option == "--split=widest") {
+      strategy = split_widest;
+    } else if (option == "--split=smear") {
+      strategy = split_smear;
+    } else if (option == "--no-descent") {
+      point_search = false;
+    } else if (option == "--cluster") {
+      cluster = true;
+    } else if (option.compare(0,13,"--time-limit=") == 0) {
+      time_limit = stod(option.substr(13));
+    } else if (option.compare(0,18,"--max-evaluations=") == 0) {
+      max_evaluations = stoull(option.substr(18));
+    } else if (option == "--trace-incumbent") {
+      on_new_upper_bound = trace_incumbent(cerr);
+    } else if (option == "--best-first") {
+      best_first = true;
+    } else if (option.compare(0,13,"--best-first=") == 0) {
+      best_first = true;
+      dive = true;
+      max_pending = stoul(option.substr(13));
+    } else if (option.compare(0,9,"--memory=") == 0) {
+      best_first = true;
+      max_resident = (stoul(option.substr(9)) << 20)/sizeof(pending_box);
+      if (max_resident == 0) {
+	cerr << "--memory needs at least 1 MB" << endl;
+	return 1;
+      }
+    } else {
+      cerr << "Unknown option: " << argv[i] << endl;
+      return 1;
+    }
+  }
+  if (use_gradient && best_first) {
+    cerr << "--best-first cannot be used with --gradient" << endl;
+    return 1;
+  }
+  if (use_gradient && use_affine) {
+    cerr << "--affine cannot be used with --gradient" << endl;
+    return 1;
+  }
+  if (max_resident != 0) {
+    // The search never dives once the pending boxes can be spilled
+    if (dive) {
+      cerr << "--memory cannot be used with --best-first=N" << endl;
+      return 1;
+    }
+    max_pending = numeric_limits<size_t>::max();
+  }
+
   // By default, the currently known upper bound for the minimizer is +oo
   double min_ub = numeric_limits<double>::infinity();
   // List of potential minimizers. They may be removed from the list
@@ -92,6 +707,10 @@ int main(void)
 
   // The information on the function chosen (pointer and initial box)
   opt_fun_t fun;
+  // Number of variables of the function chosen if it is not binary,
+  // with its name without the dimension
+  unsigned int dimension = 0;
+  string name_n;
   
   bool good_choice;
   // Asking the user for the name of the function to optimize
@@ -103,6 +722,10 @@ int main(void)
     for (auto fname : functions) {
       cout << fname.first << " ";
     }
+    for (auto fname : functions_n<min_dimension>()) {
+      cout << fname.first << "-N ";
+    }
+    cout << "(" << min_dimension << " <= N <= " << max_dimension << ")";
     cout << endl;
     cin >> choice_fun;
    	//choice_fun = "goldstein_price";
@@ -110,20 +733,80 @@ int main(void)
     try {
       fun = functions.at(choice_fun);
     } catch (out_of_range) {
-      cerr << "Bad choice" << endl;
-      good_choice = false;
+      dimension = parse_dimension(choice_fun,name_n);
+      if (dimension == 0) {
+	cerr << "Bad choice" << endl;
+	good_choice = false;
+      }
     }
   } while(!good_choice);
 
+  if (dimension != 0
+      && (use_gradient || use_affine || best_first || strategy != split_four
+	  || cluster)) {
+    cerr << "Only --no-descent, the budget and --trace-incumbent apply to"
+	 << " functions of more than two variables" << endl;
+    return 1;
+  }
+
   // Asking for the threshold below which a box is not split further
   cout << "Precision? ";
   cin >> precision;
   //precision = 0.007;
-  minimize(fun.f,fun.x,fun.y,precision,min_ub,minimums);
+  size_t nminimizers;
+  // Smallest lower bound of the minimizers
+  double min_lb = numeric_limits<double>::infinity();
+  {
+    // Interval operators require upward rounding during the whole search
+    upward_rounding rounding;
+    domain_x = fun.x;
+    domain_y = fun.y;
+    if (time_limit > 0) {
+      budget.limit_time(time_limit);
+    }
+    if (max_evaluations > 0) {
+      budget.limit_evaluations(max_evaluations);
+    }
+    if (dimension != 0) {
+      nminimizers = minimize_dimension<min_dimension>(dimension,name_n,
+						      precision,min_ub,min_lb);
+    } else if (use_gradient) {
+      minimize_gradient(fun,fun.x,fun.y,precision,min_ub,minimums);
+    } else if (best_first) {
+      minimize_best_first(use_affine ? fun.fa : fun.f,fun.g,
+			  fun.x,fun.y,precision,min_ub,minimums,max_pending,
+			  max_resident);
+    } else {
+      minimize(use_affine ? fun.fa : fun.f,fun.g,
+	       fun.x,fun.y,precision,min_ub,minimums);
+    }
+    if (dimension == 0) {
+      nminimizers = minimums.size();
+    }
+  }
   
   // Displaying all potential minimizers
+  minimums.sort();
+  if (minimums.begin() != minimums.end()) {
+    min_lb = minimums.begin()->lbmin;
+  }
   /*copy(minimums.begin(),minimums.end(),
        ostream_iterator<minimizer>(cout,"\n"));   */ 
-  cout << "Number of minimizers: " << minimums.size() << endl;
+  cout << "Number of minimizers: " << nminimizers << endl;
   cout << "Upper bound for minimum: " << min_ub << endl;
+  if (budget.exhausted()) {
+    // The minimum may lie in the boxes left unexplored as well
+    cout << "Search stopped by the budget" << endl;
+    cout << "Lower bound for minimum: "
+	 << min(min_lb,budget.unexplored_bound()) << endl;
+  }
+  cout << "Number of boxes evaluated: " << evaluated_boxes << endl;
+  cout << "Number of boxes pruned: " << pruned_boxes << endl;
+  cout << "Number of points evaluated: " << evaluated_points << endl;
+  if (cluster) {
+    vector<minimizer> clusters = cluster_minimizers(minimums);
+    cout << "Number of clusters: " << clusters.size() << endl;
+    copy(clusters.begin(),clusters.end(),
+	 ostream_iterator<minimizer>(cout,"\n"));
+  }
 }
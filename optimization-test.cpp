@@ -58,10 +58,8 @@ void minimize(itvfun f,  // Function to minimize
     min_ub = fxy.right();
     // Discarding all saved boxes whose minimum lower bound is 
     // greater than the new minimum upper bound
-    auto discard_begin = ml.lower_bound(minimizer{0,0,min_ub,0});
-	
 		#pragma  omp critical 
-		ml.erase(discard_begin,ml.end());
+		ml.discard_above(min_ub);
   }
 
   // Checking whether the input box is small enough to stop searching.
@@ -81,6 +79,9 @@ void minimize(itvfun f,  // Function to minimize
   split_box(x,y,xl,xr,yl,yr);
 
   #pragma omp parallel  
+  {
+	// The rounding direction is not shared by the threads of the team
+	upward_rounding rounding;
 	#pragma omp sections
 	{
 		#pragma omp section
@@ -91,6 +92,7 @@ void minimize(itvfun f,  // Function to minimize
 		minimize(f,xr,yl,threshold,min_ub,ml);
 		#pragma omp section
 		minimize(f,xr,yr,threshold,min_ub,ml);
+	}
   }
 }
 
@@ -149,10 +151,8 @@ void minimize_mpi(itvfun f,  // Function to minimize
     min_ub = fxy.right();
     // Discarding all saved boxes whose minimum lower bound is 
     // greater than the new minimum upper bound
-    auto discard_begin = ml.lower_bound(minimizer{0,0,min_ub,0});
-	
 		#pragma  omp critical 
-		ml.erase(discard_begin,ml.end());
+		ml.discard_above(min_ub);
   }
 
   // Checking whether the input box is small enough to stop searching.
@@ -251,12 +251,15 @@ int main(int argc, char *argv[])
 		//cin >> precision;
 		precision = 0.0007;
 
+		// Interval operators require upward rounding during the whole search
+		upward_rounding rounding;
   	minimize_mpi(fun.f,fun.x,fun.y,precision,min_ub,minimums);
 	} else {
 		itvfun f;
 		interval x, y;
 		MPI_Recv_Interval(f, x, y, precision, min_ub);
 
+		upward_rounding rounding;
 		minimize(f, x, y, precision, min_ub,minimums);
 			
 	}
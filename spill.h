@@ -0,0 +1,143 @@
+/*
+  Spill --
+
+  On-disk store of the boxes that do not fit in memory. The boxes are
+  spilled in runs: each run is written sorted to a temporary file that
+  is memory-mapped to be read back. The files are unlinked as soon as
+  they are created, so that they never outlive the process. take()
+  returns the best box over all the runs, i.e., the boxes are read back
+  in the order defined by Compare, which is the ordering of a
+  std::priority_queue (Compare(a, b) is true if a comes after b).
+
+  T must be trivially copyable since it is stored as raw bytes.
+*/
+
+#ifndef __spill_h__
+#define __spill_h__
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+template<typename T, typename Compare>
+class spill_store {
+  static_assert(std::is_trivially_copyable<T>::value,
+		"Spilled items are stored as raw bytes");
+public:
+  spill_store() : count(0) {}
+  spill_store(const spill_store&) = delete;
+  spill_store& operator=(const spill_store&) = delete;
+
+  ~spill_store()
+  {
+    for (run& r : runs) {
+      release(r);
+    }
+  }
+
+  // Moves all the items of v to a new run. v is left empty
+  void spill(std::vector<T>& v)
+  {
+    if (v.empty()) {
+      return;
+    }
+    Compare after;
+    std::sort(v.begin(),v.end(),
+	      [&after](const T& a, const T& b) { return after(b,a); });
+
+    const char* dir = std::getenv("TMPDIR");
+    std::string name = std::string(dir ? dir : "/tmp") + "/spill-XXXXXX";
+    int fd = mkstemp(&name[0]);
+    if (fd < 0) {
+      fail("mkstemp");
+    }
+    unlink(name.c_str());
+    std::size_t bytes = v.size()*sizeof(T);
+    const char* p = reinterpret_cast<const char*>(v.data());
+    for (std::size_t done = 0; done < bytes; ) {
+      ssize_t n = write(fd,p+done,bytes-done);
+      if (n < 0) {
+	close(fd);
+	fail("write");
+      }
+      done += n;
+    }
+    void* m = mmap(nullptr,bytes,PROT_READ,MAP_PRIVATE,fd,0);
+    close(fd);
+    if (m == MAP_FAILED) {
+      fail("mmap");
+    }
+    madvise(m,bytes,MADV_SEQUENTIAL);
+    runs.push_back(run{static_cast<const T*>(m),0,v.size()});
+    count += v.size();
+    v.clear();
+  }
+
+  bool empty(void) const { return count == 0; }
+  std::size_t size(void) const { return count; }
+
+  // Best item over all the runs. The store must not be empty
+  const T& top(void) const
+  {
+    return head(best());
+  }
+
+  // Removes and returns the best item. The store must not be empty
+  T take(void)
+  {
+    std::size_t k = best();
+    T t = head(k);
+    --count;
+    if (++runs[k].next == runs[k].size) {
+      release(runs[k]);
+      runs.erase(runs.begin()+k);
+    }
+    return t;
+  }
+
+private:
+  struct run {
+    const T* items; // Mapping of the file, sorted from the best item on
+    std::size_t next; // Index of the first item not read back yet
+    std::size_t size;
+  };
+
+  const T& head(std::size_t k) const { return runs[k].items[runs[k].next]; }
+
+  // Index of the run whose head is the best one
+  std::size_t best(void) const
+  {
+    Compare after;
+    std::size_t k = 0;
+    for (std::size_t i = 1; i < runs.size(); ++i) {
+      if (after(head(k),head(i))) {
+	k = i;
+      }
+    }
+    return k;
+  }
+
+  static void release(run& r)
+  {
+    munmap(const_cast<T*>(r.items),r.size*sizeof(T));
+  }
+
+  static void fail(const char* what)
+  {
+    throw std::runtime_error(std::string("spill_store: ") + what + ": "
+			     + std::strerror(errno));
+  }
+
+  std::vector<run> runs;
+  std::size_t count; // Number of items not read back yet
+};
+
+#endif // __spill_h__
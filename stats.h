@@ -0,0 +1,167 @@
+/*
+  Statistics --
+
+  Counters of what a thread does during the search: boxes evaluated
+  (with a histogram of their depths in the search tree), boxes pruned
+  by the upper bound, boxes accepted as minimizers, minimizers erased
+  afterwards, improvements of the upper bound and boxes stolen from the
+  other threads. Each thread updates its own search_stats without any
+  synchronization; they are added up once the search is over.
+
+  The counters cost a few increments per box. They are removed at
+  compile time by defining SEARCH_STATS to 0 (make STATS=0): the
+  statements in SEARCH_STAT() are then not compiled and all the
+  counters stay at 0.
+*/
+
+#ifndef __stats_h__
+#define __stats_h__
+
+#include <algorithm>
+#include <cmath>
+#include <chrono>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#ifndef SEARCH_STATS
+#   define SEARCH_STATS 1
+#endif
+
+#if SEARCH_STATS
+#   define SEARCH_STAT(statement) statement
+#else
+#   define SEARCH_STAT(statement)
+#endif
+
+struct search_stats {
+  static const int max_depth = 64;
+
+  unsigned long long evaluated = 0; // Boxes over which f was evaluated
+  unsigned long long pruned = 0; // Boxes discarded by the upper bound
+  unsigned long long accepted = 0; // Boxes saved as minimizers
+  unsigned long long erased = 0; // Minimizers discarded later on
+  unsigned long long improvements = 0; // Lowerings of the upper bound
+  double last_improvement = 0; // Seconds from the start to the last one
+  unsigned long long steals = 0; // Boxes taken from other threads
+  // Boxes evaluated at each depth, the deepest ones being counted at
+  // max_depth-1
+  unsigned long long by_depth[max_depth] = {};
+
+  // Start of the search, from boxes whose widest side is root_width
+  void begin(double root_width)
+  {
+    this->root_width = root_width;
+    start = std::chrono::steady_clock::now();
+  }
+
+  // Counting of a box whose widest side is width. Since each split
+  // halves the sides, its depth is the base 2 logarithm of the ratio of
+  // root_width to width, rounded to the nearest integer.
+  void count_evaluation(double width)
+  {
+    ++evaluated;
+    int depth = (width > 0) ? std::ilogb(1.5*(root_width/width)) : max_depth-1;
+    ++by_depth[(depth < 0) ? 0 : (depth < max_depth) ? depth : max_depth-1];
+  }
+
+  void count_improvement(void)
+  {
+    ++improvements;
+    last_improvement = std::chrono::duration<double>(std::chrono::steady_clock::now()-start).count();
+  }
+
+  // Adds the counters of s, e.g., those of another thread
+  void add(const search_stats& s)
+  {
+    evaluated += s.evaluated;
+    pruned += s.pruned;
+    accepted += s.accepted;
+    erased += s.erased;
+    improvements += s.improvements;
+    last_improvement = std::fmax(last_improvement,s.last_improvement);
+    steals += s.steals;
+    for (int i = 0; i < max_depth; ++i) {
+      by_depth[i] += s.by_depth[i];
+    }
+  }
+
+  // Depth of the deepest boxes evaluated, plus one
+  int depths(void) const
+  {
+    int n = max_depth;
+    while (n > 0 && by_depth[n-1] == 0) {
+      --n;
+    }
+    return n;
+  }
+
+  void write_text(std::ostream& os, const std::string& name) const
+  {
+    os << name << ": " << evaluated << " boxes evaluated, "
+       << pruned << " pruned, " << accepted << " accepted, "
+       << erased << " erased, " << improvements
+       << " improvements (last after " << last_improvement << " s), "
+       << steals << " steals\n";
+    os << name << " by depth:";
+    for (int i = 0; i < depths(); ++i) {
+      os << " " << by_depth[i];
+    }
+    os << "\n";
+  }
+
+  void write_json(std::ostream& os) const
+  {
+    os << "{\"evaluated\": " << evaluated << ", \"pruned\": " << pruned
+       << ", \"accepted\": " << accepted << ", \"erased\": " << erased
+       << ", \"improvements\": " << improvements
+       << ", \"last_improvement\": " << last_improvement
+       << ", \"steals\": " << steals << ", \"by_depth\": [";
+    for (int i = 0; i < depths(); ++i) {
+      os << (i ? ", " : "") << by_depth[i];
+    }
+    os << "]}";
+  }
+
+private:
+  double root_width = 1;
+  std::chrono::steady_clock::time_point start;
+};
+
+// Counters of each part of a search (thread or MPI rank), followed by
+// their sum and by the load imbalance: the ratio of the largest number
+// of boxes evaluated by a part to the mean one. Written as text or as
+// one JSON object.
+inline void write_stats(std::ostream& os, const std::vector<search_stats>& parts,
+			const std::string& part, bool json)
+{
+  search_stats total;
+  unsigned long long most = 0;
+  for (const search_stats& s : parts) {
+    total.add(s);
+    most = std::max(most,s.evaluated);
+  }
+  double imbalance = (total.evaluated > 0) ? double(most)*parts.size()/total.evaluated : 1;
+
+  // The times and the ratio do not need the precision of the bounds
+  std::streamsize precision = os.precision(6);
+  if (json) {
+    os << "{\"" << part << "s\": [";
+    for (std::size_t i = 0; i < parts.size(); ++i) {
+      os << (i ? ", " : "");
+      parts[i].write_json(os);
+    }
+    os << "], \"total\": ";
+    total.write_json(os);
+    os << ", \"imbalance\": " << imbalance << "}\n";
+  } else {
+    for (std::size_t i = 0; i < parts.size(); ++i) {
+      parts[i].write_text(os,"Statistics of " + part + " " + std::to_string(i));
+    }
+    total.write_text(os,"Statistics of all " + part + "s");
+    os << "Load imbalance: " << imbalance << "\n";
+  }
+  os.precision(precision);
+}
+
+#endif // __stats_h__
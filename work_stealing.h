@@ -0,0 +1,515 @@
+/*
+  Work stealing --
+
+  Branch-and-bound minimization of a binary function by a team of
+  OpenMP threads sharing the boxes by work stealing. Used by
+  optimization-omp, and by each process of optimization-mpi on the
+  boxes it is given.
+
+  The search can write periodic checkpoints (see checkpoint.h). A
+  checkpoint is a snapshot of the boxes waiting in the deques, of the
+  boxes being explored and of the minimizers found from the other boxes:
+  each thread explores a box with its own minimizer list and only adds
+  the minimizers found to its shared state once the box is done. The
+  snapshot is taken while holding the locks of all the threads, which
+  they only take to exchange boxes, and it is written to disk by another
+  thread, so that the workers never wait for the disk.
+
+  The search can also be given a budget (see budget.h), after which the
+  boxes left are only bounded, not explored.
+
+  Each thread counts what it does in its own search_stats (see
+  stats.h), which can be read once the search is over.
+*/
+
+#ifndef __work_stealing_h__
+#define __work_stealing_h__
+
+#include <iostream>
+#include <string>
+#include <cmath>
+#include <deque>
+#include <vector>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <atomic>
+#include <random>
+#include <iterator>
+#include <algorithm>
+#include <new>
+#include <thread>
+#include <stdexcept>
+#include "interval.h"
+#include "functions.h"
+#include "minimizer.h"
+#include "incumbent.h"
+#include "checkpoint.h"
+#include "budget.h"
+#include "stats.h"
+
+#if _OPENMP
+#   include <omp.h>
+#else
+inline int omp_get_max_threads(void) { return 1; }
+inline int omp_get_thread_num(void) { return 0; }
+#endif
+
+// Split a 2D box into four subboxes by splitting each dimension
+// into two equal subparts
+inline void split_box(const interval& x, const interval& y,
+		      interval &xl, interval& xr, interval& yl, interval& yr)
+{
+  double xm = x.mid();
+  double ym = y.mid();
+  xl = interval(x.left(),xm);
+  xr = interval(xm,x.right());
+  yl = interval(y.left(),ym);
+  yr = interval(ym,y.right());
+}
+
+// Evaluation of f over the box x*y, updating the current upper bound
+// and the list of minimizers. Returns true if the box has to be split,
+// which is never the case once the budget is exhausted
+inline bool bound_box(itvfun f,  // Function to minimize
+		      const interval& x, // Current bounds for 1st dimension
+		      const interval& y, // Current bounds for 2nd dimension
+		      double threshold,  // Threshold at which we should stop splitting
+		      cached_incumbent& min_ub,  // Current minimum upper bound
+		      minimizer_list& ml, // Minimizers found by the current thread
+		      budget_meter& meter, // Budget of the current thread
+		      search_stats& stats) // Counters of the current thread
+{
+  interval fxy = f(x,y);
+  meter.spend();
+  SEARCH_STAT(stats.count_evaluation(std::fmax(x.width(),y.width())));
+
+  if (fxy.left() > min_ub.load()) { // Current box cannot contain minimum?
+    SEARCH_STAT(++stats.pruned);
+    return false;
+  }
+
+  if (min_ub.lower(fxy.right())) { // Current box contains a new minimum?
+    ml.discard_above(fxy.right());
+    SEARCH_STAT(stats.count_improvement());
+  }
+
+  // Checking whether the input box is small enough to stop searching.
+  // Both widths are tested since the domain, hence each box, need not
+  // be square
+  if (x.width() <= threshold && y.width() <= threshold) {
+    // We have potentially a new minimizer. The boxes saved before a
+    // better upper bound was found by another thread are discarded
+    // as well.
+    double ub = min_ub.load();
+    if (fxy.left() <= ub) {
+      ml.discard_above(ub);
+      ml.insert(minimizer{x,y,fxy.left(),fxy.right()});
+      SEARCH_STAT(++stats.accepted);
+    } else {
+      SEARCH_STAT(++stats.pruned);
+    }
+    return false;
+  }
+
+  if (meter.exhausted()) { // The box is left unexplored
+    meter.skip(fxy.left());
+    return false;
+  }
+  return true;
+}
+
+// Branch-and-bound minimization algorithm, run sequentially by one
+// thread on the boxes too small to be shared
+inline void minimize(itvfun f,  // Function to minimize
+		     const interval& x, // Current bounds for 1st dimension
+		     const interval& y, // Current bounds for 2nd dimension
+		     double threshold,  // Threshold at which we should stop splitting
+		     cached_incumbent& min_ub,  // Current minimum upper bound
+		     minimizer_list& ml, // Minimizers found by the current thread
+		     budget_meter& meter, // Budget of the current thread
+		     search_stats& stats) // Counters of the current thread
+{
+  if (!bound_box(f,x,y,threshold,min_ub,ml,meter,stats)) {
+    return ;
+  }
+
+  // The box is still large enough => we split it into 4 sub-boxes
+  // and recursively explore them
+  interval xl, xr, yl, yr;
+  split_box(x,y,xl,xr,yl,yr);
+
+  minimize(f,xl,yl,threshold,min_ub,ml,meter,stats);
+  minimize(f,xl,yr,threshold,min_ub,ml,meter,stats);
+  minimize(f,xr,yl,threshold,min_ub,ml,meter,stats);
+  minimize(f,xr,yr,threshold,min_ub,ml,meter,stats);
+}
+
+// State of one thread, protected by its lock. The owner pushes and
+// pops its tasks at the back, which keeps its own exploration
+// depth-first, while idle threads steal the oldest ones, which are
+// also the largest, at the front.
+struct thread_state {
+  std::mutex lock;
+  std::deque<task> tasks;
+  // Box being explored, if busy
+  task current;
+  bool busy = false;
+  // Minimizers found from the boxes fully explored
+  minimizer_list found;
+  // Written by the owner only, without the lock
+  search_stats stats;
+  // Keeps the states of two threads on different cache lines
+  char padding[64];
+};
+
+// Branch-and-bound minimization algorithm sharing the boxes between
+// the threads by work stealing. Each thread explores its own boxes
+// depth-first and takes some from a random other thread when it runs
+// out of them. The minimizers found by a thread are kept in its own
+// list until the end of the search, when the lists are merged.
+class work_stealing_search {
+public:
+  // A box is explored sequentially by the thread that owns it once its
+  // subtree has at most sequential_levels levels of splitting left, i.e.,
+  // whatever the number of boxes waiting: a larger box is always split
+  // into tasks that the other threads may steal, since the work of a
+  // search concentrates around the minimizers and a large subtree
+  // explored sequentially could hold most of it.
+  static const int sequential_levels = 4;
+
+  // An idle thread yields yield_rounds times, then sleeps for
+  // exponentially longer periods, up to max_backoff microseconds (see
+  // back_off)
+  static const unsigned int yield_rounds = 16;
+  static const unsigned int max_backoff = 1000;
+
+  work_stealing_search(itvfun f, double threshold, shared_incumbent& min_ub,
+		       minimizer_list& ml, int nthreads)
+    : f(f), threshold(threshold), min_ub(min_ub), ml(ml),
+      states(nthreads), pending(0), budget(&unlimited), period(0), done(false)
+  {
+    sequential_width = std::ldexp(threshold,sequential_levels);
+  }
+
+  // Stops exploring boxes once b is exhausted
+  void limit(search_budget& b) { budget = &b; }
+
+  // Writes a checkpoint of the search to path every period seconds.
+  // function is the name of f and parts the number of processes
+  // taking part in the search, which are saved in the checkpoint.
+  void checkpoint_to(const std::string& path, double period,
+		     const std::string& function, unsigned int parts = 1)
+  {
+    checkpoint_path = path;
+    this->period = period;
+    checkpoint_function = function;
+    checkpoint_parts = parts;
+  }
+
+  void run(const interval& x, const interval& y)
+  {
+    run(std::vector<task>{task{x,y}});
+  }
+
+  // Explores the boxes tasks, e.g., those of a checkpoint
+  void run(const std::vector<task>& tasks)
+  {
+    // The depths counted are those below the largest box given
+    double root_width = 0;
+    for (std::size_t i = 0; i < tasks.size(); ++i) {
+      push(i % states.size(),tasks[i]);
+      root_width = std::fmax(root_width,std::fmax(tasks[i].x.width(),
+						 tasks[i].y.width()));
+    }
+    for (thread_state& s : states) {
+      s.stats.begin(root_width);
+    }
+
+    std::thread checkpointer;
+    if (period > 0) {
+      checkpointer = std::thread(&work_stealing_search::write_checkpoints,this);
+    }
+    #pragma omp parallel num_threads(states.size())
+    {
+      // The rounding direction is not shared by the threads of the team
+      upward_rounding rounding;
+      work(omp_get_thread_num());
+    }
+    if (checkpointer.joinable()) {
+      {
+	std::lock_guard<std::mutex> guard(done_lock);
+	done = true;
+      }
+      done_signal.notify_one();
+      checkpointer.join();
+    }
+
+    // The upper bound is final once no box is left: each thread has
+    // filtered its list against it
+    ml.discard_above(min_ub.load());
+    for (thread_state& s : states) {
+      SEARCH_STAT(s.stats.erased = s.found.erased());
+      ml.merge(s.found);
+      s.found.clear();
+    }
+
+    // Final checkpoint, without any box left, so that a process that
+    // is done before the first period still leaves its checkpoint
+    if (period > 0) {
+      save_checkpoint();
+    }
+  }
+
+  int threads(void) const { return states.size(); }
+
+  // Counters of thread i
+  const search_stats& thread_stats(int i) const { return states[i].stats; }
+
+  // Counters of all the threads
+  search_stats stats(void) const
+  {
+    search_stats total;
+    for (const thread_state& s : states) {
+      total.add(s.stats);
+    }
+    return total;
+  }
+
+private:
+  // Main loop of thread me: runs until no box is left anywhere
+  void work(int me)
+  {
+    std::minstd_rand victims(me+1);
+    cached_incumbent ub(min_ub);
+    budget_meter meter(*budget);
+    minimizer_list found;
+    std::vector<task> children;
+    task t;
+    unsigned int idle_rounds = 0;
+    while (pending.load() > 0) {
+      if (pop(me,t) || steal(me,victims,t)) {
+	explore(t,ub,found,children,meter,states[me].stats);
+	commit(me,found,children,ub.load());
+	pending.fetch_sub(1);
+	idle_rounds = 0;
+      } else {
+	back_off(idle_rounds++);
+      }
+    }
+
+    std::lock_guard<std::mutex> guard(states[me].lock);
+    states[me].found.discard_above(ub.latest());
+    states[me].found.compact();
+  }
+
+  // Explores the box t, saving the minimizers found in ml and the
+  // subboxes to share in children
+  void explore(const task& t, cached_incumbent& min_ub,
+	       minimizer_list& ml, std::vector<task>& children,
+	       budget_meter& meter, search_stats& stats)
+  {
+    // The cutoff is on the widest side, for a box that is not square
+    if (std::fmax(t.x.width(),t.y.width()) <= sequential_width) {
+      minimize(f,t.x,t.y,threshold,min_ub,ml,meter,stats);
+      return ;
+    }
+    if (!bound_box(f,t.x,t.y,threshold,min_ub,ml,meter,stats)) {
+      return ;
+    }
+    interval xl, xr, yl, yr;
+    split_box(t.x,t.y,xl,xr,yl,yr);
+    children.push_back(task{xr,yr});
+    children.push_back(task{xr,yl});
+    children.push_back(task{xl,yr});
+    children.push_back(task{xl,yl});
+  }
+
+  // End of the exploration of the current box of thread me: its
+  // subboxes and its minimizers are made part of the state of the
+  // thread at once
+  void commit(int me, minimizer_list& found, std::vector<task>& children,
+	      double ub)
+  {
+    // Counted before being visible so that pending never drops to 0
+    // while some box is left
+    pending.fetch_add(children.size());
+    std::lock_guard<std::mutex> guard(states[me].lock);
+    states[me].tasks.insert(states[me].tasks.end(),
+			    children.begin(),children.end());
+    states[me].found.discard_above(ub);
+    states[me].found.merge(found);
+    states[me].busy = false;
+    found.clear();
+    children.clear();
+  }
+
+  void push(int me, const task& t)
+  {
+    pending.fetch_add(1);
+    std::lock_guard<std::mutex> guard(states[me].lock);
+    states[me].tasks.push_back(t);
+  }
+
+  bool pop(int me, task& t)
+  {
+    std::lock_guard<std::mutex> guard(states[me].lock);
+    if (states[me].tasks.empty()) {
+      return false;
+    }
+    t = states[me].tasks.back();
+    states[me].tasks.pop_back();
+    states[me].current = t;
+    states[me].busy = true;
+    return true;
+  }
+
+  bool steal(int me, std::minstd_rand& victims, task& t)
+  {
+    int n = states.size();
+    if (n == 1) {
+      return false;
+    }
+    // Trying each other thread once, starting from a random one. The
+    // box stolen becomes the current one of the thief while the lock
+    // of the victim is held, so that a snapshot sees it in either place
+    int first = victims() % n;
+    for (int i = 0; i < n; ++i) {
+      int victim = (first+i) % n;
+      if (victim == me) {
+	continue;
+      }
+      std::lock_guard<std::mutex> guard(states[victim].lock);
+      if (!states[victim].tasks.empty()) {
+	t = states[victim].tasks.front();
+	states[victim].tasks.pop_front();
+	states[me].current = t;
+	states[me].busy = true;
+	SEARCH_STAT(++states[me].stats.steals);
+	return true;
+      }
+    }
+    return false;
+  }
+
+  // Wait of a thread that found no box rounds times in a row, so that
+  // the idle threads neither keep a core busy nor keep taking the locks
+  // of the others while the last boxes are explored
+  static void back_off(unsigned int rounds)
+  {
+    if (rounds < yield_rounds) {
+      std::this_thread::yield();
+      return ;
+    }
+    unsigned int shift = std::min(rounds-yield_rounds,10u);
+    std::this_thread::sleep_for(std::chrono::microseconds(std::min(1u << shift,
+								   max_backoff)));
+  }
+
+  // Consistent state of the search: no box can move from one thread to
+  // another while the locks of all the threads are held. Returns false
+  // if the budget is exhausted: the boxes left unexplored since then
+  // are lost, and the previous checkpoint must be kept.
+  //
+  // Only the boxes are copied under the locks. The minimizers found by
+  // each thread, which may be millions, are taken out of its state at
+  // once and copied after the locks are released; they are then given
+  // back to the thread along with those it committed meanwhile, under
+  // its lock only.
+  bool snapshot(checkpoint& c)
+  {
+    c.function = checkpoint_function;
+    c.threshold = threshold;
+    c.parts = checkpoint_parts;
+    std::vector<minimizer_list> taken(states.size());
+    {
+      std::vector<std::unique_lock<std::mutex>> guards;
+      for (thread_state& s : states) {
+	guards.emplace_back(s.lock);
+      }
+      // A thread only leaves a box aside after having seen the budget
+      // exhausted, and it commits it under its lock
+      if (budget->exhausted()) {
+	return false;
+      }
+      c.min_ub = min_ub.load();
+      for (std::size_t i = 0; i < states.size(); ++i) {
+	thread_state& s = states[i];
+	c.tasks.insert(c.tasks.end(),s.tasks.begin(),s.tasks.end());
+	if (s.busy) {
+	  c.tasks.push_back(s.current);
+	}
+	std::swap(s.found,taken[i]);
+      }
+    }
+
+    // ml holds the minimizers of the checkpoint the search resumed
+    // from, if any
+    double ub = c.min_ub;
+    auto useful = [ub](const minimizer& m) { return m.lbmin <= ub; };
+    bool copied = true;
+    try {
+      for (const minimizer_list& found : taken) {
+	std::copy_if(found.begin(),found.end(),
+		     std::back_inserter(c.minimizers),useful);
+      }
+      std::copy_if(ml.begin(),ml.end(),std::back_inserter(c.minimizers),useful);
+    } catch (std::bad_alloc&) {
+      copied = false;
+    }
+
+    for (std::size_t i = 0; i < states.size(); ++i) {
+      std::lock_guard<std::mutex> guard(states[i].lock);
+      taken[i].merge(states[i].found);
+      std::swap(states[i].found,taken[i]);
+    }
+    if (!copied) {
+      throw std::runtime_error("Not enough memory for a checkpoint");
+    }
+    return true;
+  }
+
+  void save_checkpoint(void)
+  {
+    checkpoint c;
+    try {
+      if (snapshot(c)) {
+	write_checkpoint(checkpoint_path,c);
+      }
+    } catch (std::exception& e) {
+      std::cerr << e.what() << std::endl;
+    }
+  }
+
+  // Body of the checkpointing thread
+  void write_checkpoints(void)
+  {
+    std::unique_lock<std::mutex> guard(done_lock);
+    auto wait = std::chrono::duration<double>(period);
+    while (!done_signal.wait_for(guard,wait,[this] { return done; })) {
+      save_checkpoint();
+    }
+  }
+
+  itvfun f;
+  double threshold;
+  double sequential_width;
+  shared_incumbent& min_ub;
+  minimizer_list& ml;
+  std::vector<thread_state> states;
+  // Number of boxes pushed and not fully explored yet
+  std::atomic<long> pending;
+  search_budget unlimited;
+  search_budget* budget;
+
+  // Periodic checkpoints (period 0: none)
+  std::string checkpoint_path;
+  double period;
+  std::string checkpoint_function;
+  unsigned int checkpoint_parts;
+  std::mutex done_lock;
+  std::condition_variable done_signal;
+  bool done;
+};
+
+#endif // __work_stealing_h__